@@ -0,0 +1,327 @@
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocale>
+#include <zlib.h>
+#include "assets.h"
+#include "controller.h"
+#include "logger.h"
+
+#ifdef BROTLI_ENABLED
+#include <brotli/encode.h>
+#endif
+
+AssetCache::AssetCache(QSettings *config, QObject *parent) : QObject(parent), m_watcher(new QFileSystemWatcher(this))
+{
+    m_path = QDir::cleanPath(config->value("server/frontend", "/usr/share/homed-web").toString());
+    m_static = config->value("server/cacheStatic", QStringList {"/js/lib/", "/font/", "/img/"}).toStringList();
+    m_staticPolicy = QString("public, max-age=%1").arg(config->value("server/cacheMaxAge", CACHE_MAX_AGE).toInt()).toUtf8();
+    m_fileLimit = config->value("server/cacheFileLimit", CACHE_FILE_LIMIT).toLongLong();
+    m_types = {"css", "js", "json", "png", "svg", "woff2"};
+
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, &AssetCache::fileChanged);
+    m_watcher->addPath(QString(m_path).append("/index.html"));
+}
+
+void AssetCache::init(void)
+{
+    QDirIterator it(m_path, QDir::Files, QDirIterator::Subdirectories);
+    qint64 size = 0;
+
+    while (it.hasNext())
+    {
+        QString fileName = it.next().mid(m_path.length());
+        Asset asset;
+
+        if (fileName.endsWith(".gz") || fileName.endsWith(".br"))
+            continue;
+
+        asset = load(fileName);
+
+        if (asset.isNull() || !asset->file().isNull())
+            continue;
+
+        size += asset->data().length() + asset->gzip().length() + asset->brotli().length();
+    }
+
+    updateIndex();
+    bundle();
+
+    logInfo << "Frontend cache contains" << m_assets.count() << "files," << size << "bytes total";
+}
+
+Asset AssetCache::get(const QString &fileName)
+{
+    QString path = QDir::cleanPath(fileName);
+
+    {
+        QReadLocker lock(&m_lock);
+        auto it = m_assets.find(path);
+
+        if (it != m_assets.end())
+            return it.value();
+    }
+
+    if (!path.startsWith('/') || path.startsWith("/.."))
+        return Asset();
+
+    if (path == HTML_BUNDLE)
+        return bundle();
+
+    return load(path);
+}
+
+Asset AssetCache::index(bool auth)
+{
+    {
+        QReadLocker lock(&m_lock);
+
+        if (!m_index.isNull())
+            return auth ? m_indexAuth : m_index;
+    }
+
+    updateIndex();
+
+    QReadLocker lock(&m_lock);
+    return auth ? m_indexAuth : m_index;
+}
+
+Asset AssetCache::load(const QString &fileName)
+{
+    QFile file(QString(m_path).append(fileName)), gzipFile(file.fileName() + ".gz"), brotliFile(file.fileName() + ".br");
+    QByteArray type = fileType(fileName), cacheControl = "no-cache";
+    QDateTime modified;
+    Asset asset;
+
+    if (!file.open(QFile::ReadOnly))
+        return Asset();
+
+    modified = QFileInfo(file).lastModified().toUTC();
+    modified.setTime(QTime(modified.time().hour(), modified.time().minute(), modified.time().second()));
+
+    for (int i = 0; i < m_static.count(); i++)
+    {
+        if (!fileName.startsWith(m_static.at(i)))
+            continue;
+
+        cacheControl = m_staticPolicy;
+        break;
+    }
+
+    if (m_fileLimit && file.size() > m_fileLimit)
+    {
+        QSharedPointer <QFile> mapped(new QFile(file.fileName()));
+        uchar *data = nullptr;
+
+        if (!mapped->open(QFile::ReadOnly) || !(data = mapped->map(0, mapped->size())))
+            return Asset();
+
+        asset = Asset(new AssetObject(type, QByteArray::fromRawData(reinterpret_cast <char*> (data), static_cast <int> (mapped->size())), modified));
+        asset->setETag(QString("%1-%2").arg(mapped->size(), 0, 16).arg(modified.toSecsSinceEpoch(), 0, 16).toUtf8());
+        asset->setCacheControl(cacheControl);
+        asset->setFile(mapped);
+        return asset;
+    }
+
+    asset = Asset(new AssetObject(type, file.readAll(), modified));
+    asset->setETag(QCryptographicHash::hash(asset->data(), QCryptographicHash::Sha1).toHex().left(20));
+    asset->setCacheControl(cacheControl);
+    file.close();
+
+    if (type.startsWith("text/") || type == "application/json" || type == "image/svg+xml")
+    {
+        QByteArray data;
+
+        if (gzipFile.open(QFile::ReadOnly))
+        {
+            data = gzipFile.readAll();
+            gzipFile.close();
+        }
+        else
+            data = gzip(asset->data());
+
+        if (!data.isEmpty() && data.length() < asset->data().length())
+            asset->setGzip(data);
+
+        if (brotliFile.open(QFile::ReadOnly))
+        {
+            data = brotliFile.readAll();
+            brotliFile.close();
+        }
+        else
+            data = brotli(asset->data());
+
+        if (!data.isEmpty() && data.length() < asset->data().length())
+            asset->setBrotli(data);
+    }
+
+    QWriteLocker lock(&m_lock);
+    m_assets.insert(fileName, asset);
+    return asset;
+}
+
+QString AssetCache::httpDate(const QDateTime &dateTime)
+{
+    return QLocale::c().toString(dateTime.toUTC(), "ddd, dd MMM yyyy hh:mm:ss 'GMT'");
+}
+
+QDateTime AssetCache::httpDate(const QString &value)
+{
+    QDateTime dateTime = QLocale::c().toDateTime(value.trimmed(), "ddd, dd MMM yyyy hh:mm:ss 'GMT'");
+    dateTime.setTimeSpec(Qt::UTC);
+    return dateTime;
+}
+
+Asset AssetCache::create(const QByteArray &type, const QByteArray &data, const QDateTime &modified, const QByteArray &cacheControl)
+{
+    Asset asset(new AssetObject(type, data, modified));
+    QByteArray buffer;
+
+    asset->setETag(QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex().left(20));
+    asset->setCacheControl(cacheControl);
+
+    buffer = gzip(data);
+
+    if (!buffer.isEmpty() && buffer.length() < data.length())
+        asset->setGzip(buffer);
+
+    buffer = brotli(data);
+
+    if (!buffer.isEmpty() && buffer.length() < data.length())
+        asset->setBrotli(buffer);
+
+    return asset;
+}
+
+Asset AssetCache::render(const Asset &asset, bool auth)
+{
+    QByteArray data = asset->data();
+    data.replace("{{version}}", SERVICE_VERSION).replace("{{logout}}", auth ? "<span id=\"logout\"><i class=\"icon-enable\"></i> LOGOUT</span>" : QByteArray());
+    return create(asset->type(), data, asset->modified(), asset->cacheControl());
+}
+
+Asset AssetCache::bundle(void)
+{
+    QDirIterator it(QString(m_path).append("/html"), {"*.html"}, QDir::Files, QDirIterator::Subdirectories);
+    QJsonObject json;
+    QDateTime modified;
+    Asset asset;
+
+    while (it.hasNext())
+    {
+        QString fileName = it.next().mid(m_path.length());
+        Asset item = get(fileName);
+
+        if (item.isNull())
+            continue;
+
+        if (modified.isNull() || modified < item->modified())
+            modified = item->modified();
+
+        json.insert(fileName.mid(1), QString::fromUtf8(item->data()));
+    }
+
+    asset = create("application/json", QJsonDocument(json).toJson(QJsonDocument::Compact), modified.isNull() ? QDateTime::currentDateTimeUtc() : modified, "no-cache");
+
+    QWriteLocker lock(&m_lock);
+    m_assets.insert(HTML_BUNDLE, asset);
+    return asset;
+}
+
+void AssetCache::updateIndex(void)
+{
+    Asset asset = load("/index.html"), page, pageAuth;
+
+    if (!asset.isNull())
+    {
+        page = render(asset, false);
+        pageAuth = render(asset, true);
+    }
+
+    QWriteLocker lock(&m_lock);
+    m_index = page;
+    m_indexAuth = pageAuth;
+}
+
+QByteArray AssetCache::fileType(const QString &fileName)
+{
+    switch (m_types.indexOf(fileName.mid(fileName.lastIndexOf('.') + 1)))
+    {
+        case 0:  return "text/css";         // css
+        case 1:  return "text/javascript";  // js
+        case 2:  return "application/json"; // json
+        case 3:  return "image/png";        // png
+        case 4:  return "image/svg+xml";    // svg
+        case 5:  return "font/woff2";       // woff2
+        default: return "text/html";
+    }
+}
+
+QByteArray AssetCache::gzip(const QByteArray &data)
+{
+    QByteArray buffer;
+    z_stream stream;
+
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+
+    if (data.isEmpty() || deflateInit2(&stream, GZIP_LEVEL, Z_DEFLATED, MAX_WBITS + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK)
+        return QByteArray();
+
+    buffer.resize(static_cast <int> (deflateBound(&stream, static_cast <uLong> (data.length()))));
+
+    stream.next_in = reinterpret_cast <Bytef*> (const_cast <char*> (data.constData()));
+    stream.avail_in = static_cast <uInt> (data.length());
+    stream.next_out = reinterpret_cast <Bytef*> (buffer.data());
+    stream.avail_out = static_cast <uInt> (buffer.length());
+
+    if (deflate(&stream, Z_FINISH) != Z_STREAM_END)
+    {
+        deflateEnd(&stream);
+        return QByteArray();
+    }
+
+    buffer.resize(static_cast <int> (stream.total_out));
+    deflateEnd(&stream);
+
+    return buffer;
+}
+
+QByteArray AssetCache::brotli(const QByteArray &data)
+{
+#ifdef BROTLI_ENABLED
+    QByteArray buffer;
+    size_t length;
+
+    if (data.isEmpty())
+        return QByteArray();
+
+    length = BrotliEncoderMaxCompressedSize(static_cast <size_t> (data.length()));
+    buffer.resize(static_cast <int> (length));
+
+    if (!BrotliEncoderCompress(BROTLI_QUALITY, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT, static_cast <size_t> (data.length()), reinterpret_cast <const uint8_t*> (data.constData()), &length, reinterpret_cast <uint8_t*> (buffer.data())))
+        return QByteArray();
+
+    buffer.resize(static_cast <int> (length));
+    return buffer;
+#else
+    Q_UNUSED(data)
+    return QByteArray();
+#endif
+}
+
+void AssetCache::fileChanged(const QString &fileName)
+{
+    logInfo << "Frontend file" << fileName << "changed, rendering index page";
+    updateIndex();
+
+    if (m_watcher->files().contains(fileName))
+        return;
+
+    m_watcher->addPath(fileName);
+}
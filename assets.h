@@ -0,0 +1,98 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#define GZIP_LEVEL          6
+#define BROTLI_QUALITY      6
+#define CACHE_MAX_AGE       604800
+#define CACHE_FILE_LIMIT    1048576
+#define HTML_BUNDLE         "/html/bundle.json"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileSystemWatcher>
+#include <QMap>
+#include <QObject>
+#include <QReadWriteLock>
+#include <QSettings>
+#include <QSharedPointer>
+
+class AssetObject
+{
+
+public:
+
+    AssetObject(const QByteArray &type, const QByteArray &data, const QDateTime &modified) : m_type(type), m_data(data), m_modified(modified) {}
+
+    inline QByteArray type(void) { return m_type; }
+    inline QByteArray data(void) { return m_data; }
+    inline QDateTime modified(void) { return m_modified; }
+
+    inline QByteArray etag(void) { return m_etag; }
+    inline void setETag(const QByteArray &value) { m_etag = value; }
+
+    inline QByteArray cacheControl(void) { return m_cacheControl; }
+    inline void setCacheControl(const QByteArray &value) { m_cacheControl = value; }
+
+    inline QByteArray gzip(void) { return m_gzip; }
+    inline void setGzip(const QByteArray &value) { m_gzip = value; }
+
+    inline QByteArray brotli(void) { return m_brotli; }
+    inline void setBrotli(const QByteArray &value) { m_brotli = value; }
+
+    inline QSharedPointer <QFile> file(void) { return m_file; }
+    inline void setFile(const QSharedPointer <QFile> &value) { m_file = value; }
+
+private:
+
+    QByteArray m_type, m_data, m_gzip, m_brotli, m_etag, m_cacheControl;
+    QDateTime m_modified;
+    QSharedPointer <QFile> m_file;
+
+};
+
+typedef QSharedPointer <AssetObject> Asset;
+
+class AssetCache : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    AssetCache(QSettings *config, QObject *parent);
+
+    void init(void);
+    Asset get(const QString &fileName);
+    Asset index(bool auth);
+
+    static QString httpDate(const QDateTime &dateTime);
+    static QDateTime httpDate(const QString &value);
+
+private:
+
+    QFileSystemWatcher *m_watcher;
+
+    QString m_path;
+    QList <QString> m_types, m_static;
+    QByteArray m_staticPolicy;
+    qint64 m_fileLimit;
+    QMap <QString, Asset> m_assets;
+    Asset m_index, m_indexAuth;
+    QReadWriteLock m_lock;
+
+    Asset load(const QString &fileName);
+    Asset create(const QByteArray &type, const QByteArray &data, const QDateTime &modified, const QByteArray &cacheControl);
+    Asset render(const Asset &asset, bool auth);
+    Asset bundle(void);
+    void updateIndex(void);
+
+    QByteArray fileType(const QString &fileName);
+    QByteArray gzip(const QByteArray &data);
+    QByteArray brotli(const QByteArray &data);
+
+private slots:
+
+    void fileChanged(const QString &fileName);
+
+};
+
+#endif
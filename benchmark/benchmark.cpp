@@ -0,0 +1,224 @@
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkRequest>
+#include <QTcpServer>
+#include <algorithm>
+#include <unistd.h>
+#include "benchmark.h"
+#include "http.h"
+#include "retained.h"
+#include "subscriptions.h"
+
+Benchmark::Benchmark(const QUrl &url, const QString &token, int clients, int rate, int duration, qint64 pid) : m_timer(new QTimer(this)), m_rate(rate), m_duration(duration), m_connected(0), m_index(0), m_pid(pid), m_sent(0), m_received(0), m_bytes(0), m_cpu(0)
+{
+    QNetworkRequest request(url);
+
+    if (!token.isEmpty())
+        request.setRawHeader("Cookie", QString("homed-auth-token=%1").arg(token).toUtf8());
+
+    connect(m_timer, &QTimer::timeout, this, &Benchmark::publish);
+
+    for (int i = 0; i < clients; i++)
+    {
+        QWebSocket *client = new QWebSocket(QString(), QWebSocketProtocol::VersionLatest, this);
+
+        connect(client, &QWebSocket::connected, this, &Benchmark::connected);
+        connect(client, &QWebSocket::textMessageReceived, this, &Benchmark::textMessageReceived);
+
+        m_clients.append(client);
+        client->open(request);
+    }
+}
+
+void Benchmark::parser(int count)
+{
+    QByteArray request = "GET /js/app.js?1700000000000 HTTP/1.1\r\nHost: localhost:8080\r\nUser-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0 Safari/537.36\r\nAccept: */*\r\nAccept-Encoding: gzip, deflate, br\r\nAccept-Language: en-US,en;q=0.9\r\nCookie: homed-auth-token=0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef\r\nIf-None-Match: \"0123456789abcdef0123\"\r\nConnection: keep-alive\r\n\r\n";
+    QTcpServer server;
+    QTcpSocket client, *socket;
+    QElapsedTimer timer;
+    qint64 length = request.length() * count, parsed = 0;
+
+    server.listen(QHostAddress::LocalHost);
+    client.connectToHost(QHostAddress::LocalHost, server.serverPort());
+
+    if (!client.waitForConnected() || !server.waitForNewConnection(1000))
+        return;
+
+    socket = server.nextPendingConnection();
+    client.write(request.repeated(count));
+
+    while (socket->bytesAvailable() < length)
+    {
+        client.waitForBytesWritten(10);
+        socket->waitForReadyRead(10);
+    }
+
+    ConnectionObject connection(socket);
+    timer.start();
+
+    while (connection.parse() && connection.status() == ConnectionObject::Status::Ready)
+    {
+        connection.reset();
+        parsed++;
+    }
+
+    report("http parser", parsed, timer.nsecsElapsed());
+}
+
+void Benchmark::matcher(int count)
+{
+    QList <QString> filters = {"service/#", "status/web", "status/zigbee", "expose/zigbee/#", "device/zigbee/#", "fd/+/+/common", "recorder"}, topics;
+    SubscriptionTree tree;
+    QElapsedTimer timer;
+    qint64 matched = 0;
+
+    for (int i = 0; i < 500; i++)
+    {
+        filters.append(QString("fd/zigbee/device_%1/%2").arg(i).arg(i % 4 ? QString::number(i % 4) : "common"));
+        topics.append(QString("fd/zigbee/device_%1/%2").arg(i).arg(i % 4 ? QString::number(i % 4) : "common"));
+    }
+
+    topics.append({"status/zigbee", "expose/zigbee/device_1", "service/zigbee", "td/zigbee/device_1"});
+
+    for (int i = 0; i < filters.count(); i++)
+        tree.insert(filters.at(i), reinterpret_cast <QWebSocket*> (static_cast <quintptr> (i + 1) * 16));
+
+    timer.start();
+
+    for (int i = 0; i < count; i++)
+        matched += tree.match(topics.at(i % topics.count())).count();
+
+    report("subscription tree match", count, timer.nsecsElapsed());
+    timer.start();
+
+    for (int i = 0; i < count; i++)
+        for (int j = 0; j < filters.count(); j++)
+            matched += SubscriptionTree::topicMatch(filters.at(j), topics.at(i % topics.count())) ? 1 : 0;
+
+    report("linear topic match", count, timer.nsecsElapsed());
+    Q_UNUSED(matched)
+}
+
+void Benchmark::retained(int count)
+{
+    QList <QString> filters = {"expose/zigbee/#", "device/+/device_10", "status/zigbee", "expose/zigbee/device_77"};
+    RetainedCache cache;
+    QElapsedTimer timer;
+    qint64 matched = 0;
+
+    for (int i = 0; i < 1000; i++)
+    {
+        cache.insert(QString("expose/zigbee/device_%1").arg(i), QString("{\"topic\":\"expose/zigbee/device_%1\",\"message\":{}}").arg(i));
+        cache.insert(QString("device/zigbee/device_%1").arg(i), QString("{\"topic\":\"device/zigbee/device_%1\",\"message\":{}}").arg(i));
+    }
+
+    cache.insert("status/zigbee", "{\"topic\":\"status/zigbee\",\"message\":{}}");
+    timer.start();
+
+    for (int i = 0; i < count; i++)
+    {
+        QList <QString> list = cache.topics(filters.at(i % filters.count()));
+
+        for (int j = 0; j < list.count(); j++)
+            matched += cache.value(list.at(j)).length();
+    }
+
+    report("retained cache match", count, timer.nsecsElapsed());
+    Q_UNUSED(matched)
+}
+
+qint64 Benchmark::cpuTime(void)
+{
+    QFile file(QString("/proc/%1/stat").arg(m_pid));
+    QList <QByteArray> list;
+
+    if (!m_pid || !file.open(QFile::ReadOnly))
+        return 0;
+
+    list = file.readAll().split(')').value(1).trimmed().split(' ');
+    return list.value(11).toLongLong() + list.value(12).toLongLong();
+}
+
+QByteArray Benchmark::processStatus(const QByteArray &key)
+{
+    QFile file(QString("/proc/%1/status").arg(m_pid));
+    QList <QByteArray> list;
+
+    if (!m_pid || !file.open(QFile::ReadOnly))
+        return QByteArray();
+
+    list = file.readAll().split('\n');
+
+    for (int i = 0; i < list.count(); i++)
+        if (list.at(i).startsWith(key))
+            return list.at(i).mid(key.length() + 1).trimmed();
+
+    return QByteArray();
+}
+
+void Benchmark::report(const QString &name, qint64 count, qint64 elapsed)
+{
+    printf("%-28s %10lld ops %10.1f ns/op %12.0f ops/s\n", qPrintable(name), count, count ? static_cast <double> (elapsed) / count : 0, elapsed ? count * 1e9 / elapsed : 0);
+}
+
+void Benchmark::connected(void)
+{
+    QWebSocket *client = reinterpret_cast <QWebSocket*> (sender());
+    int index = m_clients.indexOf(client);
+
+    client->sendTextMessage(QJsonDocument(QJsonObject {{"action", "subscribe"}, {"topic", QString("fd/benchmark/%1").arg(index % BENCHMARK_TOPICS)}}).toJson(QJsonDocument::Compact));
+
+    if (++m_connected < m_clients.count())
+        return;
+
+    printf("%d clients connected, publishing %d messages/s for %d seconds\n", m_connected, m_rate, m_duration);
+
+    m_cpu = cpuTime();
+    m_clock.start();
+    m_timer->start(BENCHMARK_TICK);
+
+    QTimer::singleShot(m_duration * 1000, this, &Benchmark::finish);
+}
+
+void Benchmark::textMessageReceived(const QString &message)
+{
+    QJsonObject json = QJsonDocument::fromJson(message.toUtf8()).object();
+
+    if (!json.value("topic").toString().startsWith("fd/benchmark/"))
+        return;
+
+    m_latency.append(m_clock.nsecsElapsed() - static_cast <qint64> (json.value("message").toObject().value("timestamp").toDouble()));
+    m_bytes += message.length();
+    m_received++;
+}
+
+void Benchmark::publish(void)
+{
+    qint64 target = m_clock.elapsed() * m_rate / 1000;
+
+    while (m_sent < target)
+    {
+        m_clients.first()->sendTextMessage(QJsonDocument(QJsonObject {{"action", "publish"}, {"topic", QString("fd/benchmark/%1").arg(m_index++ % BENCHMARK_TOPICS)}, {"message", QJsonObject {{"timestamp", static_cast <double> (m_clock.nsecsElapsed())}}}}).toJson(QJsonDocument::Compact));
+        m_sent++;
+    }
+}
+
+void Benchmark::finish(void)
+{
+    double elapsed = m_clock.elapsed() / 1000.0;
+
+    m_timer->stop();
+    std::sort(m_latency.begin(), m_latency.end());
+
+    printf("published %lld, received %lld frames, %.0f frames/s, %.0f bytes/s\n", m_sent, m_received, m_received / elapsed, m_bytes / elapsed);
+
+    if (!m_latency.isEmpty())
+        printf("latency p50 %.2f ms, p99 %.2f ms\n", m_latency.at(m_latency.count() / 2) / 1e6, m_latency.at(m_latency.count() * 99 / 100) / 1e6);
+
+    if (m_pid)
+        printf("service cpu %.1f%%, rss %s\n", (cpuTime() - m_cpu) * 100.0 / sysconf(_SC_CLK_TCK) / elapsed, processStatus("VmRSS:").constData());
+
+    QCoreApplication::quit();
+}
@@ -0,0 +1,48 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#define BENCHMARK_TICK      10
+#define BENCHMARK_TOPICS    16
+
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QWebSocket>
+
+class Benchmark : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    Benchmark(const QUrl &url, const QString &token, int clients, int rate, int duration, qint64 pid);
+
+    static void parser(int count);
+    static void matcher(int count);
+    static void retained(int count);
+
+private:
+
+    QTimer *m_timer;
+    QElapsedTimer m_clock;
+
+    QList <QWebSocket*> m_clients;
+    QList <qint64> m_latency;
+
+    int m_rate, m_duration, m_connected, m_index;
+    qint64 m_pid, m_sent, m_received, m_bytes, m_cpu;
+
+    qint64 cpuTime(void);
+    QByteArray processStatus(const QByteArray &key);
+
+    static void report(const QString &name, qint64 count, qint64 elapsed);
+
+private slots:
+
+    void connected(void);
+    void textMessageReceived(const QString &message);
+    void publish(void);
+    void finish(void);
+
+};
+
+#endif
@@ -0,0 +1,20 @@
+QT += network websockets
+QT -= gui
+
+CONFIG += console
+TARGET = homed-web-benchmark
+
+INCLUDEPATH += ..
+
+HEADERS += \
+    ../http.h \
+    ../retained.h \
+    ../subscriptions.h \
+    benchmark.h
+
+SOURCES += \
+    ../http.cpp \
+    ../retained.cpp \
+    ../subscriptions.cpp \
+    benchmark.cpp \
+    main.cpp
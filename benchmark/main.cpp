@@ -0,0 +1,25 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include "benchmark.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication application(argc, argv);
+    QCommandLineParser parser;
+    QCommandLineOption url("url", "Run the load test against a running homed-web instance.", "url"), token("token", "Authentication token cookie value.", "token"), clients("clients", "Number of WebSocket clients.", "count", "100"), rate("rate", "MQTT messages per second.", "rate", "1000"), duration("duration", "Load test duration in seconds.", "seconds", "10"), pid("pid", "Service process id for CPU and RSS reporting.", "pid", "0"), count("count", "Microbenchmark iteration count.", "count", "100000");
+
+    parser.addHelpOption();
+    parser.addOptions({url, token, clients, rate, duration, pid, count});
+    parser.process(application);
+
+    if (!parser.isSet(url))
+    {
+        Benchmark::parser(parser.value(count).toInt() / 10);
+        Benchmark::matcher(parser.value(count).toInt());
+        Benchmark::retained(parser.value(count).toInt());
+        return 0;
+    }
+
+    Benchmark benchmark(QUrl(parser.value(url)), parser.value(token), parser.value(clients).toInt(), parser.value(rate).toInt(), parser.value(duration).toInt(), parser.value(pid).toLongLong());
+    return application.exec();
+}
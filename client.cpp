@@ -0,0 +1,400 @@
+#include <QCborArray>
+#include <QCborMap>
+#include <QHostAddress>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimer>
+#include "client.h"
+#include "logger.h"
+#include "subscriptions.h"
+
+ClientObject::~ClientObject(void)
+{
+    if (!m_deflate)
+        return;
+
+    deflateEnd(m_deflate);
+    delete m_deflate;
+}
+
+bool ClientObject::setDeflate(int level, int windowBits, int memLevel, bool takeover)
+{
+    if (m_deflate)
+        return true;
+
+    m_deflate = new z_stream;
+    m_deflate->zalloc = Z_NULL;
+    m_deflate->zfree = Z_NULL;
+    m_deflate->opaque = Z_NULL;
+
+    if (deflateInit2(m_deflate, level, Z_DEFLATED, -qBound(9, windowBits, MAX_WBITS), qBound(1, memLevel, MAX_MEM_LEVEL), Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        delete m_deflate;
+        m_deflate = nullptr;
+        return false;
+    }
+
+    m_takeover = takeover;
+    return true;
+}
+
+QString ClientObject::patch(const QString &topic, const QJsonObject &message, quint32 limit)
+{
+    auto it = m_deltas.find(topic);
+    QJsonObject data;
+
+    if (it == m_deltas.end() || it.value().second >= limit || !mergePatch(it.value().first, message, data))
+    {
+        m_deltas.insert(topic, {message, 0});
+        return QString();
+    }
+
+    it.value().first = message;
+    it.value().second++;
+
+    return QString::fromUtf8(QJsonDocument(QJsonObject {{"topic", topic}, {"patch", data}}).toJson(QJsonDocument::Compact));
+}
+
+void ClientObject::resetDelta(const QString &filter)
+{
+    for (auto it = m_deltas.begin(); it != m_deltas.end(); )
+    {
+        if (SubscriptionTree::topicMatch(filter, it.key()))
+            it = m_deltas.erase(it);
+        else
+            it++;
+    }
+}
+
+void ClientObject::setInterval(const QString &filter, qint64 interval)
+{
+    if (interval > 0)
+        m_intervals.insert(filter, interval);
+    else
+        m_intervals.remove(filter);
+
+    for (auto it = m_throttle.begin(); it != m_throttle.end(); )
+    {
+        if (!m_intervals.isEmpty() && !SubscriptionTree::topicMatch(filter, it.key()))
+        {
+            it++;
+            continue;
+        }
+
+        if (!it.value().frame.isNull())
+        {
+            send(it.value().frame, it.value().coalesce);
+            m_throttled--;
+        }
+
+        it = m_throttle.erase(it);
+    }
+}
+
+void ClientObject::throttle(const QString &topic, const QString &frame, const QString &coalesce)
+{
+    qint64 now;
+
+    if (m_intervals.isEmpty())
+    {
+        send(frame, coalesce);
+        return;
+    }
+
+    ThrottleItem &item = m_throttle[topic];
+
+    if (item.interval < 0)
+        item.interval = interval(topic);
+
+    if (!item.interval)
+    {
+        send(frame, coalesce);
+        return;
+    }
+
+    now = QDateTime::currentMSecsSinceEpoch();
+
+    if (item.frame.isNull() && now - item.last >= item.interval)
+    {
+        item.last = now;
+        send(frame, coalesce);
+        return;
+    }
+
+    if (item.frame.isNull())
+        m_throttled++;
+
+    item.frame = frame;
+    item.coalesce = coalesce;
+}
+
+void ClientObject::throttleFlush(void)
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    for (auto it = m_throttle.begin(); it != m_throttle.end(); it++)
+    {
+        if (it.value().frame.isNull() || now - it.value().last < it.value().interval)
+            continue;
+
+        send(it.value().frame, it.value().coalesce);
+
+        it.value().last = now;
+        it.value().frame.clear();
+        it.value().coalesce.clear();
+
+        m_throttled--;
+    }
+}
+
+void ClientObject::trace(const QString &topic, const QElapsedTimer &timer)
+{
+    if (m_trace.timer.isValid() && m_trace.timer.elapsed() < TRACE_TIMEOUT)
+        return;
+
+    m_trace.timer = timer;
+    m_trace.pattern = QString("\"topic\":\"%1\"").arg(topic);
+    m_trace.type = topic.split('/').value(0).toUtf8();
+    m_trace.mark = -1;
+}
+
+void ClientObject::send(const QString &frame, const QString &topic)
+{
+    if (m_dropped)
+        return;
+
+    if (m_batchSize)
+    {
+        auto it = topic.isEmpty() ? m_batchIndex.end() : m_batchIndex.find(topic);
+
+        if (it != m_batchIndex.end())
+        {
+            m_batchLength += frame.length() - m_batch.at(it.value()).length();
+            m_batch.replace(it.value(), frame);
+        }
+        else
+        {
+            if (!topic.isEmpty())
+                m_batchIndex.insert(topic, m_batch.count());
+
+            m_batchLength += frame.length();
+            m_batch.append(frame);
+        }
+
+        if (m_batchLength >= m_batchSize)
+            flush();
+
+        return;
+    }
+
+    enqueue(frame, topic);
+}
+
+void ClientObject::flush(void)
+{
+    QString data;
+
+    if (m_batch.isEmpty())
+        return;
+
+    data = m_batch.count() > 1 ? QString("[%1]").arg(m_batch.join(',')) : m_batch.first();
+
+    m_batch.clear();
+    m_batchIndex.clear();
+    m_batchLength = 0;
+
+    enqueue(data);
+}
+
+void ClientObject::enqueue(const QString &frame, const QString &topic)
+{
+    if (m_dropped)
+        return;
+
+    if (m_queue.isEmpty() && m_pending < CLIENT_BUFFER_SIZE)
+    {
+        write(frame);
+        return;
+    }
+
+    if (!topic.isEmpty())
+    {
+        auto it = m_latest.find(topic);
+
+        if (it != m_latest.end())
+        {
+            m_queued += frame.length() - it.value().length();
+            it.value() = frame;
+            return;
+        }
+
+        m_latest.insert(topic, frame);
+        m_queue.append(qMakePair(topic, QString()));
+    }
+    else
+        m_queue.append(qMakePair(QString(), frame));
+
+    m_queued += frame.length();
+
+    if (m_limit <= 0 || pending() <= m_limit)
+        return;
+
+    logWarning << "Client" << m_socket->peerAddress().toString() << "dropped, outbound queue exceeded" << m_limit << "bytes";
+
+    m_queue.clear();
+    m_latest.clear();
+    m_dropped = true;
+
+    QTimer::singleShot(0, m_socket, &QWebSocket::abort);
+}
+
+void ClientObject::written(qint64 bytes)
+{
+    m_pending = qMax <qint64> (m_pending - bytes, 0);
+    m_flushed += bytes;
+
+    if (m_trace.mark >= 0 && (m_flushed >= m_trace.mark || !m_pending))
+    {
+        m_metrics->traceFlush(m_trace.type, m_trace.timer.nsecsElapsed() / 1000);
+        m_trace.timer.invalidate();
+        m_trace.mark = -1;
+    }
+
+    while (!m_queue.isEmpty() && m_pending < CLIENT_BUFFER_SIZE)
+    {
+        QPair <QString, QString> item = m_queue.takeFirst();
+        QString frame = item.first.isEmpty() ? item.second : m_latest.take(item.first);
+
+        m_queued -= frame.length();
+        write(frame);
+    }
+}
+
+void ClientObject::write(const QString &frame)
+{
+    qint64 length;
+
+    if (m_cbor)
+    {
+        QByteArray data = cbor(frame);
+        length = data.isEmpty() ? m_socket->sendTextMessage(frame) : m_socket->sendBinaryMessage(data);
+    }
+    else
+        length = m_deflate ? m_socket->sendBinaryMessage(compress(frame.toUtf8().append('\0'))) : m_socket->sendTextMessage(frame);
+
+    if (length <= 0)
+        return;
+
+    m_metrics->frameSent(length);
+    m_pending += length + (length < 126 ? 2 : length < 65536 ? 4 : 10);
+
+    if (!m_trace.timer.isValid() || m_trace.mark >= 0 || !frame.contains(m_trace.pattern))
+        return;
+
+    m_metrics->traceWrite(m_trace.type, m_trace.timer.nsecsElapsed() / 1000);
+    m_trace.mark = m_flushed + m_pending;
+}
+
+QByteArray ClientObject::cbor(const QString &frame)
+{
+    static QString last;
+    static QByteArray data;
+    QJsonParseError error;
+    QJsonDocument document;
+
+    if (frame.constData() == last.constData() && frame.length() == last.length())
+        return data;
+
+    document = QJsonDocument::fromJson(frame.toUtf8(), &error);
+
+    last = frame;
+    data = error.error != QJsonParseError::NoError ? QByteArray() : document.isArray() ? QCborArray::fromJsonArray(document.array()).toCborValue().toCbor() : QCborMap::fromJsonObject(document.object()).toCborValue().toCbor();
+
+    return data;
+}
+
+qint64 ClientObject::interval(const QString &topic)
+{
+    qint64 value = 0;
+
+    for (int i = 0; i < m_subscriptions.count(); i++)
+    {
+        const QString &filter = m_subscriptions.at(i);
+        qint64 item;
+
+        if (!SubscriptionTree::topicMatch(filter, topic))
+            continue;
+
+        item = m_intervals.value(filter);
+
+        if (!item)
+            return 0;
+
+        if (!value || item < value)
+            value = item;
+    }
+
+    return value;
+}
+
+QByteArray ClientObject::compress(const QByteArray &data)
+{
+    QByteArray buffer;
+
+    if (!m_takeover)
+        deflateReset(m_deflate);
+
+    m_deflate->next_in = reinterpret_cast <Bytef*> (const_cast <char*> (data.constData()));
+    m_deflate->avail_in = static_cast <uInt> (data.length());
+
+    do
+    {
+        int offset = buffer.length();
+
+        buffer.resize(offset + DEFLATE_CHUNK_SIZE);
+        m_deflate->next_out = reinterpret_cast <Bytef*> (buffer.data() + offset);
+        m_deflate->avail_out = DEFLATE_CHUNK_SIZE;
+
+        if (deflate(m_deflate, Z_SYNC_FLUSH) == Z_STREAM_ERROR)
+            return QByteArray();
+
+        buffer.resize(offset + DEFLATE_CHUNK_SIZE - static_cast <int> (m_deflate->avail_out));
+    }
+    while (!m_deflate->avail_out);
+
+    return buffer;
+}
+
+bool ClientObject::mergePatch(const QJsonObject &base, const QJsonObject &target, QJsonObject &patch)
+{
+    for (auto it = base.begin(); it != base.end(); it++)
+        if (!target.contains(it.key()))
+            patch.insert(it.key(), QJsonValue::Null);
+
+    for (auto it = target.begin(); it != target.end(); it++)
+    {
+        QJsonValue value = base.value(it.key());
+
+        if (value == it.value())
+            continue;
+
+        if (it.value().isNull())
+            return false;
+
+        if (it.value().isObject())
+        {
+            QJsonObject item;
+
+            if (!mergePatch(value.toObject(), it.value().toObject(), item))
+                return false;
+
+            patch.insert(it.key(), item);
+            continue;
+        }
+
+        patch.insert(it.key(), it.value());
+    }
+
+    return true;
+}
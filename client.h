@@ -0,0 +1,112 @@
+#ifndef CLIENT_H
+#define CLIENT_H
+
+#define CLIENT_BUFFER_SIZE      65536
+#define CLIENT_QUEUE_LIMIT      1048576
+#define DEFLATE_CHUNK_SIZE      16384
+#define TRACE_TIMEOUT           10000
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QSharedPointer>
+#include <QWebSocket>
+#include <zlib.h>
+#include "metrics.h"
+
+struct ThrottleItem
+{
+    ThrottleItem(void) : last(0), interval(-1) {}
+
+    qint64 last, interval;
+    QString frame, coalesce;
+};
+
+struct TraceItem
+{
+    TraceItem(void) : mark(-1) {}
+
+    QElapsedTimer timer;
+    QString pattern;
+    QByteArray type;
+    qint64 mark;
+};
+
+class ClientObject
+{
+
+public:
+
+    ClientObject(QWebSocket *socket, qint64 limit, Metrics *metrics) : m_socket(socket), m_metrics(metrics), m_deflate(nullptr), m_limit(limit), m_throttled(0), m_pending(0), m_queued(0), m_batchSize(0), m_batchLength(0), m_flushed(0), m_takeover(true), m_cbor(false), m_snapshot(false), m_delta(false), m_dropped(false) {}
+    ~ClientObject(void);
+
+    inline QWebSocket *socket(void) { return m_socket; }
+    inline QList <QString> &subscriptions(void) { return m_subscriptions; }
+
+    inline bool throttlePending(void) { return m_throttled > 0; }
+
+    void setInterval(const QString &filter, qint64 interval);
+    void throttle(const QString &topic, const QString &frame, const QString &coalesce);
+    void throttleFlush(void);
+
+    inline qint64 pending(void) { return m_pending + m_queued; }
+
+    inline bool batchPending(void) { return !m_batch.isEmpty(); }
+    inline void setBatchSize(qint64 value) { m_batchSize = value; }
+
+    bool setDeflate(int level, int windowBits, int memLevel, bool takeover);
+
+    inline bool cbor(void) { return m_cbor; }
+    inline void setCbor(bool value) { m_cbor = value; }
+
+    inline bool snapshot(void) { return m_snapshot; }
+    inline void setSnapshot(bool value) { m_snapshot = value; }
+
+    inline bool delta(void) { return m_delta; }
+    inline void setDelta(bool value) { m_delta = value; }
+
+    QString patch(const QString &topic, const QJsonObject &message, quint32 limit);
+    void resetDelta(const QString &filter);
+
+    void trace(const QString &topic, const QElapsedTimer &timer);
+
+    void send(const QString &frame, const QString &topic = QString());
+    void flush(void);
+    void written(qint64 bytes);
+
+private:
+
+    QWebSocket *m_socket;
+    Metrics *m_metrics;
+    QList <QString> m_subscriptions;
+    z_stream *m_deflate;
+
+    QHash <QString, qint64> m_intervals;
+    QHash <QString, ThrottleItem> m_throttle;
+
+    QList <QPair <QString, QString>> m_queue;
+    QHash <QString, QString> m_latest;
+
+    QList <QString> m_batch;
+    QHash <QString, int> m_batchIndex;
+
+    QHash <QString, QPair <QJsonObject, quint32>> m_deltas;
+    TraceItem m_trace;
+
+    qint64 m_limit, m_throttled, m_pending, m_queued, m_batchSize, m_batchLength, m_flushed;
+    bool m_takeover, m_cbor, m_snapshot, m_delta, m_dropped;
+
+    void enqueue(const QString &frame, const QString &topic = QString());
+    void write(const QString &frame);
+    qint64 interval(const QString &topic);
+
+    QByteArray compress(const QByteArray &data);
+    static QByteArray cbor(const QString &frame);
+    bool mergePatch(const QJsonObject &base, const QJsonObject &target, QJsonObject &patch);
+
+};
+
+typedef QSharedPointer <ClientObject> Client;
+
+#endif
@@ -1,344 +1,663 @@
-#include <QFile>
+#include <QCborMap>
+#include <QCborValue>
 #include "controller.h"
 #include "logger.h"
 
-Controller::Controller(const QString &configFile) : HOMEd(configFile), m_database(new Database(getConfig(), this)), m_tcpServer(new QTcpServer(this)), m_webSocket(new QWebSocketServer("HOMEd", QWebSocketServer::NonSecureMode, this))
+Controller::Controller(const QString &configFile) : HOMEd(configFile), m_assets(new AssetCache(getConfig(), this)), m_database(new Database(getConfig(), &m_metrics, this)), m_tcpServer(new Server(this)), m_batchTimer(new QTimer(this)), m_metricsTimer(new QTimer(this)), m_throttleTimer(new QTimer(this)), m_retainedTimer(new QTimer(this)), m_staleTimer(new QTimer(this)), m_schedulerTimer(new QTimer(this)), m_retainedThread(nullptr), m_retainedWriter(nullptr), m_webSocket(new QWebSocketServer("HOMEd", QWebSocketServer::NonSecureMode, this)), m_traceCount(0), m_statusSkip(false)
 {
     logInfo << "Starting version" << SERVICE_VERSION;
     logInfo << "Configuration file is" << getConfig()->fileName();
 
-    m_frontend = getConfig()->value("server/frontend", "/usr/share/homed-web").toString();
-    m_username = getConfig()->value("server/username").toString();
-    m_password = getConfig()->value("server/password").toString();
-    m_guest = getConfig()->value("server/guest").toString();
+    m_clientQueueLimit = getConfig()->value("server/clientQueueLimit", CLIENT_QUEUE_LIMIT).toLongLong();
+    m_batchSize = getConfig()->value("server/batchSize", BATCH_SIZE).toLongLong();
 
-    m_debug = getConfig()->value("server/debug", false).toBool();
-    m_auth = m_username.isEmpty() || m_password.isEmpty() ? false : true;
+    m_deflateLevel = getConfig()->value("server/deflate", false).toBool() ? getConfig()->value("server/deflateLevel", DEFLATE_LEVEL).toInt() : 0;
+    m_deflateWindowBits = getConfig()->value("server/deflateWindowBits", DEFLATE_WINDOW_BITS).toInt();
+    m_deflateMemLevel = getConfig()->value("server/deflateMemLevel", DEFLATE_MEM_LEVEL).toInt();
+    m_deflateTakeover = getConfig()->value("server/deflateContextTakeover", true).toBool();
+    m_deltaLimit = getConfig()->value("server/deltaLimit", DELTA_LIMIT).toInt();
+    m_traceRate = getConfig()->value("server/traceRate", 0).toInt();
+    m_downsample = getConfig()->value("server/recorderDownsample", true).toBool();
+
+    m_messages.setLimit(getConfig()->value("server/retainedLimit", 0).toLongLong());
 
     m_retained = {"device", "expose", "service", "status"};
-    m_types = {"css", "js", "json", "png", "svg", "woff2"};
+    m_broker.insert("command/web");
 
     connect(m_database, &Database::statusUpdated, this, &Controller::statusUpdated);
-    connect(m_tcpServer, &QTcpServer::newConnection, this, &Controller::socketConnected);
     connect(m_webSocket, &QWebSocketServer::newConnection, this, &Controller::clientConnected);
+    connect(m_batchTimer, &QTimer::timeout, this, &Controller::batchTimeout);
+    connect(m_metricsTimer, &QTimer::timeout, this, &Controller::metricsTimeout);
+    connect(m_throttleTimer, &QTimer::timeout, this, &Controller::throttleTimeout);
+    connect(m_retainedTimer, &QTimer::timeout, this, &Controller::retainedTimeout);
+    connect(m_staleTimer, &QTimer::timeout, this, &Controller::staleTimeout);
+    connect(m_schedulerTimer, &QTimer::timeout, this, &Controller::schedulerTimeout);
+
+    m_batchTimer->setInterval(getConfig()->value("server/batchInterval", BATCH_INTERVAL).toInt());
+    m_batchTimer->setSingleShot(true);
+    m_metricsTimer->start(METRICS_INTERVAL);
+    m_throttleTimer->setInterval(THROTTLE_INTERVAL);
+    m_throttleTimer->setSingleShot(true);
+    m_retainedTimer->setInterval(getConfig()->value("server/retainedInterval", RETAINED_INTERVAL).toInt());
+    m_retainedTimer->setSingleShot(true);
+    m_staleTimer->setSingleShot(true);
+    m_schedulerTimer->setSingleShot(true);
+
+    if (getConfig()->value("server/preload", true).toBool())
+        m_assets->init();
 
     m_database->init();
+
+    if (!getConfig()->value("server/retainedSnapshot").toString().isEmpty())
+    {
+        QFile file(getConfig()->value("server/retainedSnapshot").toString());
+
+        if (file.open(QFile::ReadOnly))
+        {
+            if (m_messages.load(file.readAll()))
+                logInfo << "Retained snapshot loaded," << m_messages.count() << "messages marked as stale";
+            else
+                logWarning << "Retained snapshot" << file.fileName() << "is invalid";
+
+            file.close();
+        }
+
+        m_retainedThread = new QThread(this);
+        m_retainedWriter = new DatabaseWriter(file.fileName());
+
+        connect(this, &Controller::retainedRequest, m_retainedWriter, &DatabaseWriter::store);
+
+        m_retainedWriter->moveToThread(m_retainedThread);
+        m_retainedThread->start();
+    }
+
+    m_limiter.setLimits(getConfig()->value("server/maxConnections", MAX_CONNECTIONS).toInt(), getConfig()->value("server/maxHostConnections", MAX_HOST_CONNECTIONS).toInt(), getConfig()->value("server/trustedProxies", QStringList {"127.0.0.1", "::1", "::ffff:127.0.0.1"}).toStringList());
+    qRegisterMetaType <qintptr> ("qintptr");
+
+    for (int i = 0; i < qMax(getConfig()->value("server/workers", 1).toInt(), 1); i++)
+    {
+        Worker *worker = new Worker(getConfig(), m_assets, m_database, &m_metrics, &m_limiter);
+
+        connect(worker, &Worker::upgradeRequest, this, &Controller::upgradeRequest);
+        connect(worker, &Worker::logoutRequest, this, &Controller::logoutRequest);
+
+        if (getConfig()->value("server/workers", 1).toInt() > 0)
+        {
+            QThread *thread = new QThread(this);
+
+            worker->moveToThread(thread);
+            connect(thread, &QThread::finished, worker, &Worker::deleteLater);
+
+            m_threads.append(thread);
+            thread->start();
+        }
+        else
+            worker->setParent(this);
+
+        m_tcpServer->addWorker(worker);
+    }
+
     m_tcpServer->listen(QHostAddress::Any, static_cast <quint16> (getConfig()->value("server/port", 8080).toInt()));
 }
 
-void Controller::httpResponse(QTcpSocket *socket, quint16 code, const QMap <QString, QString> &headers, const QByteArray &response)
+QByteArray Controller::messageFrame(const QString &topic, const QByteArray &message)
 {
-    QByteArray data;
+    QByteArray payload = message.trimmed(), data = QJsonDocument(QJsonObject {{"topic", topic}}).toJson(QJsonDocument::Compact);
+    QJsonParseError error;
+    bool check = payload.length() >= 3 && payload.startsWith('{') && payload.endsWith('}');
 
-    switch (code)
+    if (check)
     {
-       case 200: data = "HTTP/1.1 200 OK"; break;
-       case 301: data = "HTTP/1.1 301 Moved Permanently"; break;
-       case 404: data = "HTTP/1.1 404 Not Found"; break;
-       case 405: data = "HTTP/1.1 405 Method Not Allowed"; break;
-       case 500: data = "HTTP/1.1 500 Internal Server Error"; break;
+        QJsonDocument::fromJson(payload, &error);
+        check = error.error == QJsonParseError::NoError;
     }
 
-    for (auto it = headers.begin(); it != headers.end(); it++)
-        data.append(QString("\r\n%1: %2").arg(it.key(), it.value()).toUtf8());
+    if (!check)
+        payload = "null";
 
-    socket->write(data.append("\r\n\r\n").append(response));
-    socket->close();
+    data.chop(1);
+    return data.append(",\"message\":").append(payload).append('}');
 }
 
-void Controller::fileResponse(QTcpSocket *socket, const QString &fileName)
+void Controller::clientRequest(const Client &client, const QJsonObject &json)
 {
-    QFile file(QString(m_frontend).append(fileName));
-    QByteArray type, data;
+    QString action = json.value("action").toString(), subTopic = json.value("topic").toString();
 
-    if (!file.exists())
+    if (action == "setup")
     {
-        httpResponse(socket, 404);
+        client->setCbor(json.value("format").toString() == "cbor");
+        client->setDelta(json.value("delta").toBool());
+        client->setSnapshot(json.value("snapshot").toBool());
+
+        if (json.value("batch").toBool())
+            client->setBatchSize(m_batchSize);
+
+        if (json.value("deflate").toBool() && m_deflateLevel && !client->setDeflate(m_deflateLevel, m_deflateWindowBits, m_deflateMemLevel, m_deflateTakeover))
+            logWarning << "Client" << client->socket()->peerAddress().toString() << "compression setup failed";
+
         return;
     }
 
-    if (!file.open(QFile::ReadOnly))
-    {
-        httpResponse(socket, 500);
+    if (subTopic.isEmpty())
         return;
+
+    if (action == "subscribe" || action == "resync")
+    {
+        client->resetDelta(subTopic);
+
+        if (action == "subscribe")
+        {
+            qint64 interval = json.value("minInterval").toInt(), rate = json.value("maxRate").toInt();
+
+            if (!client->subscriptions().contains(subTopic))
+            {
+                client->subscriptions().append(subTopic);
+                m_subscriptions.insert(subTopic, client->socket());
+                m_broker.insert(subTopic);
+            }
+
+            client->setInterval(subTopic, rate > 0 ? qMax(interval, 1000 / rate) : interval);
+        }
+
+        if (m_messages.refetch(subTopic) && mqttStatus())
+        {
+            QList <QString> list = m_broker.active();
+
+            for (int i = 0; i < list.count(); i++)
+                if (SubscriptionManager::filterCovers(list.at(i), subTopic))
+                    mqttSubscribe(mqttTopic(list.at(i)));
+        }
+
+        replayCancel(client->socket(), subTopic);
+        m_replays.append({client->socket(), subTopic, m_messages.topics(subTopic), 0});
+
+        if (!m_schedulerTimer->isActive())
+            m_schedulerTimer->start(0);
+
+        updateSubscriptions();
     }
+    else if (action == "publish")
+    {
+        QJsonObject message = json.value("message").toObject();
+
+        if (subTopic.startsWith("command/") && !message.value("action").toString().startsWith("get") && client->socket()->parent() ? client->socket()->parent()->property("guest").toBool() : false)
+        {
+            client->send(QJsonDocument({{"topic", "error"}, {"message", "access denied"}}).toJson(QJsonDocument::Compact));
+            return;
+        }
+
+        if (subTopic == "command/recorder" && message.value("action").toString() == "getData" && message.contains("width"))
+        {
+            if (m_downsample)
+            {
+                QJsonObject data = m_recorder.request(message);
+
+                if (!data.isEmpty())
+                {
+                    client->send(QString::fromUtf8(messageFrame("recorder", QJsonDocument(data).toJson(QJsonDocument::Compact))));
+
+                    if (client->batchPending() && !m_batchTimer->isActive())
+                        m_batchTimer->start();
+
+                    return;
+                }
+            }
+
+            message.remove("width");
+        }
 
-    switch (m_types.indexOf(fileName.mid(fileName.lastIndexOf('.') + 1)))
+        mqttPublish(mqttTopic(subTopic), message);
+    }
+    else if (action == "unsubscribe" && client->subscriptions().removeAll(subTopic))
+    {
+        client->setInterval(subTopic, 0);
+        replayCancel(client->socket(), subTopic);
+        m_subscriptions.remove(subTopic, client->socket());
+        m_broker.remove(subTopic);
+        updateSubscriptions();
+    }
+}
+
+void Controller::replayCancel(QWebSocket *socket, const QString &filter)
+{
+    for (int i = m_replays.count() - 1; i >= 0; i--)
+        if (m_replays.at(i).socket == socket && (filter.isEmpty() || m_replays.at(i).filter == filter))
+            m_replays.removeAt(i);
+}
+
+bool Controller::replaySlice(const Client &client, ReplayJob &job)
+{
+    int end = qMin(job.index + SCHEDULER_SLICE, job.topics.count());
+    QString header, data;
+
+    if (!client->snapshot())
+    {
+        for (; job.index < end; job.index++)
+        {
+            QString frame = m_messages.value(job.topics.at(job.index));
+
+            if (frame.isNull())
+                continue;
+
+            client->send(frame);
+        }
+
+        return job.index >= job.topics.count();
+    }
+
+    header = QString::fromUtf8(QJsonDocument(QJsonObject {{"topic", "snapshot"}, {"filter", job.filter}}).toJson(QJsonDocument::Compact));
+    header.chop(1);
+
+    for (; job.index < end; job.index++)
+    {
+        QString frame = m_messages.value(job.topics.at(job.index), false);
+        int index = frame.indexOf(",\"message\":");
+
+        if (index < 0)
+            continue;
+
+        data.append(data.isEmpty() ? QString(header).append(",\"messages\":{") : QString(",")).append(frame.mid(9, index - 9)).append(':').append(frame.mid(index + 11, frame.length() - index - 12));
+
+        if (data.length() < SNAPSHOT_SIZE)
+            continue;
+
+        client->send(data.append("}}"));
+        data.clear();
+    }
+
+    if (!data.isEmpty())
+        client->send(data.append("}}"));
+
+    if (job.index < job.topics.count())
+        return false;
+
+    client->send(header + ",\"end\":true}");
+    return true;
+}
+
+void Controller::updateSubscriptions(void)
+{
+    QList <QString> subscribe, unsubscribe, active;
+
+    m_broker.update(subscribe, unsubscribe);
+    active = m_broker.active();
+
+    for (int i = 0; i < unsubscribe.count(); i++)
     {
-        case 0:  type = "text/css"; break;         // css
-        case 1:  type = "text/javascript"; break;  // js
-        case 2:  type = "application/json"; break; // json
-        case 3:  type = "image/png"; break;        // png
-        case 4:  type = "image/svg+xml"; break;    // svg
-        case 5:  type = "font/woff2"; break;       // woff2
-        default: type = "text/html"; break;
+        QList <QString> list = m_messages.topics(unsubscribe.at(i));
+
+        for (int j = 0; j < list.count(); j++)
+        {
+            bool covered = false;
+
+            for (int k = 0; k < active.count(); k++)
+            {
+                if (!SubscriptionTree::topicMatch(active.at(k), list.at(j)))
+                    continue;
+
+                covered = true;
+                break;
+            }
+
+            if (!covered)
+                m_messages.remove(list.at(j));
+        }
     }
 
-    data = file.readAll();
+    if (!unsubscribe.isEmpty() && m_retainedWriter && !m_retainedTimer->isActive())
+        m_retainedTimer->start();
+
+    if (!mqttStatus())
+        return;
 
-    if (fileName == "/index.html")
-        data = QString(data).arg(SERVICE_VERSION, m_auth ? "<span id=\"logout\"><i class=\"icon-enable\"></i> LOGOUT</span>" : QString()).toUtf8();
+    for (int i = 0; i < subscribe.count(); i++)
+        mqttSubscribe(mqttTopic(subscribe.at(i)));
 
-    httpResponse(socket, 200, {{"Content-Type", type}, {"Content-Length", QString::number(data.length())}}, data);
-    file.close();
+    for (int i = 0; i < unsubscribe.count(); i++)
+        mqttUnsubscribe(mqttTopic(unsubscribe.at(i)));
 }
 
 void Controller::quit(void)
 {
     m_webSocket->close();
 
+    m_tcpServer->close();
+
     for (auto it = m_clients.begin(); it != m_clients.end(); it++)
         it.key()->deleteLater();
 
+    for (int i = 0; i < m_threads.count(); i++)
+    {
+        m_threads.at(i)->quit();
+        m_threads.at(i)->wait();
+    }
+
+    if (m_retainedWriter)
+    {
+        m_retainedThread->quit();
+        m_retainedThread->wait();
+
+        m_retainedWriter->store(m_messages.data());
+        delete m_retainedWriter;
+        m_retainedWriter = nullptr;
+    }
+
     HOMEd::quit();
 }
 
 void Controller::mqttConnected(void)
 {
-    mqttSubscribe(mqttTopic("command/web"));
+    QList <QString> unused;
 
-    for (auto it = m_clients.begin(); it != m_clients.end(); it++)
-        for (int i = 0; i < it.value().count(); i++)
-            mqttSubscribe(mqttTopic(it.value().at(i)));
+    m_broker.update(unused, unused);
+    m_resubscribe = m_broker.active();
+
+    if (!m_schedulerTimer->isActive())
+        m_schedulerTimer->start(0);
 
+    m_staleTimer->start(getConfig()->value("server/staleTimeout", STALE_TIMEOUT).toInt());
     m_database->store();
     mqttPublishStatus();
 }
 
 void Controller::mqttDisconnected(void)
 {
-    m_messages.clear();
+    m_staleTimer->stop();
+    m_messages.expire();
+    m_resubscribe.clear();
 }
 
 void Controller::mqttReceived(const QByteArray &message, const QMqttTopicName &topic)
 {
-    QString subTopic = topic.name().replace(mqttTopic(), QString());
-    QJsonObject json = QJsonDocument::fromJson(message).object();
+    QString subTopic = topic.name().replace(mqttTopic(), QString()), item = subTopic.split('/').value(0), frame, coalesce;
+    QSet <QWebSocket*> clients;
+    QJsonObject json;
+    QElapsedTimer timer;
+    bool parsed = false, trace = m_traceRate && !(++m_traceCount % m_traceRate);
 
-    if (subTopic == "command/web" && json.value("action").toString() == "updateDashboards")
-    {
-        m_database->update(json.value("data").toArray());
-        m_database->store(true);
-        return;
-    }
+    if (trace)
+        timer.start();
 
-    if (m_retained.contains(subTopic.split('/').value(0)))
-        m_messages.insert(subTopic, message);
+    m_metrics.mqttReceived();
 
-    for (auto it = m_clients.begin(); it != m_clients.end(); it++)
+    if (subTopic == "command/web")
     {
-        for (int i = 0; i < it.value().count(); i++)
+        QJsonObject json = QJsonDocument::fromJson(message).object();
+        QString action = json.value("action").toString();
+
+        if (action == "updateDashboards")
         {
-            const QString item = it.value().at(i);
+            m_database->update(json.value("data").toArray());
+            m_database->store(true);
+            m_statusSkip = false;
+            return;
+        }
 
-            if (item.endsWith('#') ? !subTopic.startsWith(item.mid(0, item.indexOf("#"))) : subTopic != item)
-                continue;
+        if (action.endsWith("Dashboard") || action == "reorderDashboards")
+        {
+            QJsonObject event = m_database->patch(json);
 
-            it.key()->sendTextMessage(QJsonDocument({{"topic", subTopic}, {"message", json.isEmpty() ? QJsonValue::Null : QJsonValue(json)}}).toJson(QJsonDocument::Compact));
-            break;
+            if (event.isEmpty())
+                return;
+
+            mqttPublish(mqttTopic("event/web"), event);
+            m_database->store(true);
+            m_statusSkip = true;
+            return;
         }
     }
-}
 
-void Controller::statusUpdated(const QJsonObject &json)
-{
-    mqttPublish(mqttTopic("status/web"), json, true);
-}
+    clients = m_subscriptions.match(subTopic);
 
-void Controller::socketConnected(void)
-{
-    QTcpSocket *socket = m_tcpServer->nextPendingConnection();
-    connect(socket, &QTcpSocket::disconnected, this, &Controller::socketDisconnected);
-    connect(socket, &QTcpSocket::readyRead, this, &Controller::readyRead);
-    m_sockets.append(socket);
-}
+    if (m_retained.contains(item))
+    {
+        frame = QString::fromUtf8(messageFrame(subTopic, message));
 
-void Controller::socketDisconnected(void)
-{
-    QTcpSocket *socket = reinterpret_cast <QTcpSocket*> (sender());
-    m_sockets.removeAll(socket);
-    socket->deleteLater();
-}
+        if (message.isEmpty())
+            m_messages.remove(subTopic);
+        else
+            m_messages.insert(subTopic, frame);
 
-void Controller::readyRead(void)
-{
-    QTcpSocket *socket = reinterpret_cast <QTcpSocket*> (sender());
-    QByteArray request = socket->peek(socket->bytesAvailable());
-    QList <QString> list = QString(request).split("\r\n\r\n"), head = list.value(0).split("\r\n"), target = head.value(0).split(0x20), cookieList, itemList;
-    QString method = target.value(0), url = target.value(1), content = list.value(1);
-    QMap <QString, QString> headers, cookies, items;
-    bool guest = false;
+        if (m_retainedWriter && !m_retainedTimer->isActive())
+            m_retainedTimer->start();
+
+        if (subTopic == "status/web" && !m_statusEcho.isEmpty() && QJsonDocument::fromJson(message).object() == m_statusEcho)
+        {
+            m_statusEcho = QJsonObject();
+            return;
+        }
+    }
+    else if (!clients.isEmpty())
+        frame = QString::fromUtf8(messageFrame(subTopic, subTopic == "recorder" ? m_recorder.response(message) : message));
 
-    disconnect(socket, &QTcpSocket::readyRead, this, &Controller::readyRead);
-    logDebug(m_debug) << "Request" << head.value(0) << "received from" << socket->peerAddress().toString();
+    if (m_retained.contains(item) || item == "fd")
+        coalesce = subTopic;
 
-    for (int i = 1; i < head.count(); i++)
+    for (auto it = clients.begin(); it != clients.end(); it++)
     {
-        QList <QString> header = head.at(i).split(':');
+        Client client = m_clients.value(*it);
 
-        if (header.count() < 2)
+        if (client.isNull())
             continue;
 
-        headers.insert(header.value(0).toLower().trimmed(), header.value(1).trimmed());
-        logDebug(m_debug) << "Header received:" << head.at(i);
-    }
+        if (trace)
+            client->trace(subTopic, timer);
 
-    cookieList = headers.value("cookie").split(';');
+        if (client->delta() && m_retained.contains(item))
+        {
+            QString patch;
 
-    for (int i = 0; i < cookieList.count(); i++)
-    {
-        QList <QString> cookie = cookieList.at(i).split('=');
+            if (!parsed)
+            {
+                json = QJsonDocument::fromJson(message).object();
+                parsed = true;
+            }
 
-        if (cookie.count() < 2)
-            continue;
+            if (!json.isEmpty())
+                patch = client->patch(subTopic, json, m_deltaLimit);
+            else
+                client->resetDelta(subTopic);
 
-        cookies.insert(cookie.value(0).trimmed(), cookie.value(1).trimmed());
-        logDebug(m_debug) << "Cookie received:" << cookieList.at(i);
-    }
+            client->send(patch.isNull() ? frame : patch);
+        }
+        else
+            client->throttle(subTopic, frame, coalesce);
 
-    if (method == "POST" && headers.value("content-length").toInt() > content.length())
-    {
-        socket->read(request.length());
-        socket->waitForReadyRead();
-        content.append(socket->readAll());
+        if (client->throttlePending() && !m_throttleTimer->isActive())
+            m_throttleTimer->start();
+
+        if (client->batchPending() && !m_batchTimer->isActive())
+            m_batchTimer->start();
     }
+}
 
-    itemList = QString(method == "GET" && url.contains('?') ? url.mid(url.indexOf('?') + 1) : content).split('&');
+void Controller::statusUpdated(const QJsonObject &json)
+{
+    m_statusEcho = m_statusSkip ? json : QJsonObject();
+    m_statusSkip = false;
+    mqttPublish(mqttTopic("status/web"), json, true);
+}
 
-    for (int i = 0; i < itemList.count(); i++)
-    {
-        QList <QString> item = itemList.at(i).split('=');
+void Controller::upgradeRequest(QTcpSocket *socket)
+{
+    connect(socket, &QTcpSocket::disconnected, socket, &QTcpSocket::deleteLater);
+    m_webSocket->handleConnection(socket);
+}
 
-        if (item.count() < 2)
-            continue;
+void Controller::logoutRequest(void)
+{
+    m_closing = m_clients.keys();
 
-        items.insert(item.value(0), QUrl::fromPercentEncoding(item.value(1).toUtf8()));
-        logDebug(m_debug) << "Data received:" << itemList.at(i);
-    }
+    if (!m_schedulerTimer->isActive())
+        m_schedulerTimer->start(0);
 
-    if (m_auth)
-    {
-        QString token = cookies.value("homed-auth-token");
+    m_database->resetAdminToken();
+    m_database->resetGuestToken();
+    m_database->store(true);
+}
 
-        if (token != m_database->adminToken() && token != m_database->guestToken() && url != "/manifest.json" && !url.startsWith("/css/") && !url.startsWith("/font/") && !url.startsWith("/img/"))
-        {
-            if (method == "POST")
-            {
-                QString username = items.value("username"), password = items.value("password");
+void Controller::clientConnected(void)
+{
+    QWebSocket *socket = m_webSocket->nextPendingConnection();
+    Client client(new ClientObject(socket, m_clientQueueLimit, &m_metrics));
 
-                if (username == m_username && password == m_password)
-                {
-                    httpResponse(socket, 301, {{"Location", QString(headers.value("x-ingress-path")).append('/')}, {"Cache-Control", "no-cache, no-store"}, {"Set-Cookie", QString("homed-auth-token=%1; path=/; max-age=%2").arg(m_database->adminToken()).arg(COOKIE_MAX_AGE)}});
-                    return;
-                }
+    connect(socket, &QWebSocket::disconnected, this, &Controller::clientDisconnected);
+    connect(socket, &QWebSocket::textMessageReceived, this, &Controller::textMessageReceived);
+    connect(socket, &QWebSocket::binaryMessageReceived, this, &Controller::binaryMessageReceived);
+    connect(socket, &QWebSocket::bytesWritten, this, &Controller::bytesWritten);
 
-                if (!m_guest.isEmpty() && username == "guest" && password == m_guest)
-                {
-                    httpResponse(socket, 301, {{"Location", QString(headers.value("x-ingress-path")).append('/')}, {"Cache-Control", "no-cache, no-store"}, {"Set-Cookie", QString("homed-auth-token=%1; path=/; max-age=%2").arg(m_database->guestToken()).arg(COOKIE_MAX_AGE)}});
-                    return;
-                }
-            }
+    if (mqttStatus())
+        client->send(QJsonDocument({{"topic", "setup"}, {"message", QJsonObject {{"guest", socket->parent() ? socket->parent()->property("guest").toBool() : false}, {"features", m_deflateLevel ? QJsonArray {"batch", "cbor", "delta", "snapshot", "deflate"} : QJsonArray {"batch", "cbor", "delta", "snapshot"}}}}}).toJson(QJsonDocument::Compact));
+    else
+        client->send(QJsonDocument({{"topic", "error"}, {"message", "mqtt disconnected"}}).toJson(QJsonDocument::Compact));
 
-            fileResponse(socket, "/login.html");
-            return;
+    m_clients.insert(socket, client);
+}
+
+void Controller::clientDisconnected(void)
+{
+    QWebSocket *socket = reinterpret_cast <QWebSocket*> (sender());
+    Client client = m_clients.take(socket);
+
+    if (!client.isNull())
+    {
+        for (int i = 0; i < client->subscriptions().count(); i++)
+        {
+            m_subscriptions.remove(client->subscriptions().at(i), socket);
+            m_broker.remove(client->subscriptions().at(i));
         }
 
-        guest = token != m_database->adminToken() ? true : false;
+        updateSubscriptions();
     }
 
-    url = url.mid(0, url.indexOf('?'));
+    replayCancel(socket, QString());
+    m_closing.removeAll(socket);
+    socket->deleteLater();
+}
 
-    if (url == "/logout")
-    {
-        httpResponse(socket, 301, {{"Location", QString(headers.value("x-ingress-path")).append('/')}, {"Cache-Control", "no-cache, no-store"}, {"Set-Cookie", "homed-auth-token=deleted; path=/; max-age=0"}});
+void Controller::bytesWritten(qint64 bytes)
+{
+    Client client = m_clients.value(reinterpret_cast <QWebSocket*> (sender()));
 
-        if (guest || items.value("session") != "all")
-            return;
+    if (client.isNull())
+        return;
 
-        for (auto it = m_clients.begin(); it != m_clients.end(); it++)
-            it.key()->deleteLater();
+    client->written(bytes);
+}
 
-        m_database->resetAdminToken();
-        m_database->resetGuestToken();
-        m_database->store(true);
-        return;
-    }
+void Controller::batchTimeout(void)
+{
+    for (auto it = m_clients.begin(); it != m_clients.end(); it++)
+        it.value()->flush();
+}
 
-    if (method != "GET")
+void Controller::throttleTimeout(void)
+{
+    bool pending = false;
+
+    for (auto it = m_clients.begin(); it != m_clients.end(); it++)
     {
-        httpResponse(socket, 405);
-        return;
+        Client client = it.value();
+
+        client->throttleFlush();
+
+        if (client->throttlePending())
+            pending = true;
+
+        if (client->batchPending() && !m_batchTimer->isActive())
+            m_batchTimer->start();
     }
 
-    if (headers.value("upgrade") == "websocket")
-    {
-        socket->setProperty("guest", guest);
-        m_webSocket->handleConnection(socket);
+    if (!pending)
         return;
-    }
 
-    fileResponse(socket, url != "/" ? url : "/index.html");
+    m_throttleTimer->start();
 }
 
-void Controller::clientConnected(void)
+void Controller::metricsTimeout(void)
 {
-    QWebSocket *client = m_webSocket->nextPendingConnection();
-    connect(client, &QWebSocket::disconnected, this, &Controller::clientDisconnected);
-    connect(client, &QWebSocket::textMessageReceived, this, &Controller::textMessageReceived);
+    qint64 queue = 0;
 
-    if (mqttStatus())
-        client->sendTextMessage(QJsonDocument({{"topic", "setup"}, {"message", QJsonObject {{"guest", client->parent() ? client->parent()->property("guest").toBool() : false}}}}).toJson(QJsonDocument::Compact));
-    else
-        client->sendTextMessage(QJsonDocument({{"topic", "error"}, {"message", "mqtt disconnected"}}).toJson(QJsonDocument::Compact));
+    for (auto it = m_clients.begin(); it != m_clients.end(); it++)
+        queue += it.value()->pending();
 
-    m_clients.insert(client, QStringList());
+    m_metrics.update(m_clients.count(), m_messages.count(), m_messages.size(), queue, METRICS_INTERVAL);
 }
 
-void Controller::clientDisconnected(void)
+void Controller::retainedTimeout(void)
 {
-    QWebSocket *client = reinterpret_cast <QWebSocket*> (sender());
-    m_clients.remove(client);
-    client->deleteLater();
+    emit retainedRequest(m_messages.data());
 }
 
-void Controller::textMessageReceived(const QString &message)
+void Controller::staleTimeout(void)
 {
-    auto it = m_clients.find(reinterpret_cast <QWebSocket*> (sender()));
-    QJsonObject json = QJsonDocument::fromJson(message.toUtf8()).object();
-    QString action = json.value("action").toString(), subTopic = json.value("topic").toString();
+    int count = m_messages.purge();
 
-    if (it == m_clients.end() || subTopic.isEmpty())
+    if (!count)
         return;
 
-    if (action == "subscribe")
-    {
-        QWebSocket* client = it.key();
+    logInfo << count << "stale retained messages removed";
 
-        if (!it.value().contains(subTopic))
-            it.value().append(subTopic);
+    if (m_retainedWriter && !m_retainedTimer->isActive())
+        m_retainedTimer->start();
+}
 
-        for (auto it = m_messages.begin(); it != m_messages.end(); it++)
+void Controller::schedulerTimeout(void)
+{
+    if (!m_resubscribe.isEmpty())
+    {
+        for (int i = 0; i < SCHEDULER_SLICE && !m_resubscribe.isEmpty(); i++)
         {
-            if (subTopic.endsWith('#') ? !it.key().startsWith(subTopic.mid(0, subTopic.indexOf("#"))) : it.key() != subTopic)
+            QString filter = m_resubscribe.takeFirst();
+
+            if (!m_broker.active(filter))
                 continue;
 
-            client->sendTextMessage(QJsonDocument({{"topic", it.key()}, {"message", QJsonDocument::fromJson(it.value()).object()}}).toJson(QJsonDocument::Compact));
+            mqttSubscribe(mqttTopic(filter));
         }
-
-        mqttSubscribe(mqttTopic(subTopic));
     }
-    else if (action == "publish")
+    else if (!m_closing.isEmpty())
     {
-        QJsonObject message = json.value("message").toObject();
+        for (int i = 0; i < SCHEDULER_SLICE && !m_closing.isEmpty(); i++)
+            m_closing.takeFirst()->deleteLater();
+    }
+    else if (!m_replays.isEmpty())
+    {
+        ReplayJob job = m_replays.takeFirst();
+        Client client = m_clients.value(job.socket);
 
-        if (subTopic.startsWith("command/") && !message.value("action").toString().startsWith("get") && it.key()->parent() ? it.key()->parent()->property("guest").toBool() : false)
+        if (!client.isNull())
         {
-            it.key()->sendTextMessage(QJsonDocument({{"topic", "error"}, {"message", "access denied"}}).toJson(QJsonDocument::Compact));
-            return;
-        }
+            if (!replaySlice(client, job) && m_clients.contains(job.socket))
+                m_replays.append(job);
 
-        mqttPublish(mqttTopic(subTopic), message);
+            if (client->batchPending() && !m_batchTimer->isActive())
+                m_batchTimer->start();
+        }
     }
-    else if (action == "unsubscribe")
-        it.value().removeAll(subTopic);
+
+    if (m_resubscribe.isEmpty() && m_closing.isEmpty() && m_replays.isEmpty())
+        return;
+
+    m_schedulerTimer->start(0);
+}
+
+void Controller::textMessageReceived(const QString &message)
+{
+    Client client = m_clients.value(reinterpret_cast <QWebSocket*> (sender()));
+
+    if (client.isNull())
+        return;
+
+    clientRequest(client, QJsonDocument::fromJson(message.toUtf8()).object());
+}
+
+void Controller::binaryMessageReceived(const QByteArray &message)
+{
+    Client client = m_clients.value(reinterpret_cast <QWebSocket*> (sender()));
+
+    if (client.isNull())
+        return;
+
+    clientRequest(client, QCborValue::fromCbor(message).toMap().toJsonObject());
 }
@@ -3,12 +3,38 @@
 
 #define SERVICE_VERSION     "2.4.5"
 #define COOKIE_MAX_AGE      31536000
-
-#include <QTcpServer>
+#define BATCH_INTERVAL      20
+#define BATCH_SIZE          16384
+#define DEFLATE_LEVEL       6
+#define DEFLATE_WINDOW_BITS 11      // per client zlib state is (1 << (windowBits + 2)) + (1 << (memLevel + 9)) bytes, 16 KB by default
+#define DEFLATE_MEM_LEVEL   4
+#define DELTA_LIMIT         100
+#define THROTTLE_INTERVAL   20
+#define SNAPSHOT_SIZE       65536
+#define RETAINED_INTERVAL   300000
+#define STALE_TIMEOUT       30000
+#define SCHEDULER_SLICE     256
+
+#include <QThread>
 #include <QWebSocket>
 #include <QWebSocketServer>
+#include "assets.h"
+#include "client.h"
 #include "database.h"
 #include "homed.h"
+#include "metrics.h"
+#include "recorder.h"
+#include "retained.h"
+#include "subscriptions.h"
+#include "worker.h"
+
+struct ReplayJob
+{
+    QWebSocket *socket;
+    QString filter;
+    QList <QString> topics;
+    int index;
+};
 
 class Controller : public HOMEd
 {
@@ -20,21 +46,41 @@ public:
 
 private:
 
+    AssetCache *m_assets;
     Database *m_database;
-    QTcpServer *m_tcpServer;
+    Server *m_tcpServer;
+    QTimer *m_batchTimer, *m_metricsTimer, *m_throttleTimer, *m_retainedTimer, *m_staleTimer, *m_schedulerTimer;
+    QThread *m_retainedThread;
+    DatabaseWriter *m_retainedWriter;
     QWebSocketServer *m_webSocket;
 
-    QString m_frontend, m_username, m_password, m_guest;
-    bool m_debug, m_auth;
-
-    QList <QString> m_retained, m_types;
-    QMap <QString, QByteArray> m_messages;
-
-    QList <QTcpSocket*> m_sockets;
-    QMap <QWebSocket*, QStringList> m_clients;
-
-    void httpResponse(QTcpSocket *socket, quint16 code, const QMap <QString, QString> &headers = QMap <QString, QString> (), const QByteArray &response = QByteArray());
-    void fileResponse(QTcpSocket *socket, const QString &fileName);
+    qint64 m_clientQueueLimit, m_batchSize;
+    int m_deflateLevel, m_deflateWindowBits, m_deflateMemLevel;
+    bool m_deflateTakeover;
+    quint32 m_deltaLimit, m_traceRate, m_traceCount;
+    bool m_downsample, m_statusSkip;
+
+    QList <QString> m_retained;
+    QJsonObject m_statusEcho;
+    Metrics m_metrics;
+    Limiter m_limiter;
+    RetainedCache m_messages;
+    RecorderProxy m_recorder;
+
+    QList <QThread*> m_threads;
+    QMap <QWebSocket*, Client> m_clients;
+    SubscriptionTree m_subscriptions;
+    SubscriptionManager m_broker;
+
+    QList <ReplayJob> m_replays;
+    QList <QString> m_resubscribe;
+    QList <QWebSocket*> m_closing;
+
+    QByteArray messageFrame(const QString &topic, const QByteArray &message);
+    void clientRequest(const Client &client, const QJsonObject &json);
+    void replayCancel(QWebSocket *socket, const QString &filter);
+    bool replaySlice(const Client &client, ReplayJob &job);
+    void updateSubscriptions(void);
 
 public slots:
 
@@ -48,13 +94,24 @@ private slots:
 
     void statusUpdated(const QJsonObject &json);
 
-    void socketConnected(void);
-    void socketDisconnected(void);
-    void readyRead(void);
+    void upgradeRequest(QTcpSocket *socket);
+    void logoutRequest(void);
 
     void clientConnected(void);
     void clientDisconnected(void);
+    void bytesWritten(qint64 bytes);
+    void batchTimeout(void);
+    void throttleTimeout(void);
+    void metricsTimeout(void);
+    void retainedTimeout(void);
+    void staleTimeout(void);
+    void schedulerTimeout(void);
     void textMessageReceived(const QString &message);
+    void binaryMessageReceived(const QByteArray &message);
+
+signals:
+
+    void retainedRequest(const QByteArray &data);
 
 };
 
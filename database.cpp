@@ -1,19 +1,52 @@
+#include <QElapsedTimer>
 #include <QRandomGenerator>
+#include <QSaveFile>
 #include "controller.h"
 #include "database.h"
 #include "logger.h"
 
-Database::Database(QSettings *config, QObject *parent) : QObject(parent), m_timer(new QTimer(this)), m_sync(false)
+void DatabaseWriter::store(const QByteArray &data)
+{
+    QSaveFile file(m_fileName);
+    QElapsedTimer timer;
+
+    timer.start();
+
+    if (!file.open(QFile::WriteOnly))
+        logWarning << "Database not stored, file" << m_fileName << "open error:" << file.errorString();
+    else if (file.write(data) != data.length())
+    {
+        logWarning << "Database not stored, file" << m_fileName << "write error:" << file.errorString();
+        file.cancelWriting();
+    }
+    else if (!file.commit())
+        logWarning << "Database not stored, file" << m_fileName << "commit error:" << file.errorString();
+
+    emit finished(timer.nsecsElapsed() / 1000);
+}
+
+Database::Database(QSettings *config, Metrics *metrics, QObject *parent) : QObject(parent), m_metrics(metrics), m_timer(new QTimer(this)), m_thread(new QThread(this)), m_sync(false), m_busy(false), m_pending(false)
 {
     m_file.setFileName(config->value("server/database", "/opt/homed-web/database.json").toString());
+    m_writer = new DatabaseWriter(m_file.fileName());
+
     connect(m_timer, &QTimer::timeout, this, &Database::write);
+    connect(this, &Database::storeRequest, m_writer, &DatabaseWriter::store);
+    connect(m_writer, &DatabaseWriter::finished, this, &Database::finished);
+
     m_timer->setSingleShot(true);
+    m_writer->moveToThread(m_thread);
+    m_thread->start();
 }
 
 Database::~Database(void)
 {
-    m_sync = true;
-    write();
+    m_thread->quit();
+    m_thread->wait();
+
+    disconnect(m_writer, nullptr, this, nullptr);
+    m_writer->store(data());
+    delete m_writer;
 }
 
 void Database::init(void)
@@ -30,6 +63,7 @@ void Database::init(void)
     m_adminToken = json.value("adminToken").toString();
     m_guestToken = json.value("guestToken").toString();
     m_dashboards = json.value("dashboards").toArray();
+    identify();
 
     if (m_adminToken.isEmpty())
     {
@@ -49,9 +83,81 @@ void Database::init(void)
     write();
 }
 
+void Database::update(const QJsonArray &data)
+{
+    m_dashboards = data;
+    identify();
+}
+
+QJsonObject Database::patch(const QJsonObject &json)
+{
+    QString action = json.value("action").toString(), id = json.value("id").toString();
+    QJsonObject data = json.value("data").toObject();
+    int index = dashboardIndex(id);
+
+    if (action == "addDashboard")
+    {
+        id = data.value("id").toString();
+
+        if (id.isEmpty() || dashboardIndex(id) >= 0)
+            id = randomData(8).toHex();
+
+        data.insert("id", id);
+        m_dashboards.append(data);
+        return {{"action", action}, {"id", id}, {"data", data}};
+    }
+
+    if (action == "reorderDashboards")
+    {
+        QJsonArray ids = json.value("ids").toArray(), list;
+
+        for (auto it = ids.begin(); it != ids.end(); it++)
+        {
+            index = dashboardIndex(it->toString());
+
+            if (index < 0)
+                continue;
+
+            list.append(m_dashboards.at(index));
+            m_dashboards.removeAt(index);
+        }
+
+        for (auto it = m_dashboards.begin(); it != m_dashboards.end(); it++)
+            list.append(*it);
+
+        m_dashboards = list;
+        ids = QJsonArray();
+
+        for (auto it = m_dashboards.begin(); it != m_dashboards.end(); it++)
+            ids.append(it->toObject().value("id"));
+
+        return {{"action", action}, {"ids", ids}};
+    }
+
+    if (index < 0)
+        return QJsonObject();
+
+    if (action == "updateDashboard")
+    {
+        data.insert("id", id);
+        m_dashboards.replace(index, data);
+        return {{"action", action}, {"id", id}, {"data", data}};
+    }
+
+    if (action == "removeDashboard")
+    {
+        m_dashboards.removeAt(index);
+        return {{"action", action}, {"id", id}};
+    }
+
+    return QJsonObject();
+}
+
 void Database::store(bool sync)
 {
-    m_sync = sync;
+    if (sync)
+        m_sync = true;
+
     m_timer->start(STORE_DELAY);
 }
 
@@ -65,11 +171,57 @@ QByteArray Database::randomData(int length)
     return data;
 }
 
+int Database::dashboardIndex(const QString &id)
+{
+    if (id.isEmpty())
+        return -1;
+
+    for (int i = 0; i < m_dashboards.count(); i++)
+        if (m_dashboards.at(i).toObject().value("id").toString() == id)
+            return i;
+
+    return -1;
+}
+
+void Database::identify(void)
+{
+    for (int i = 0; i < m_dashboards.count(); i++)
+    {
+        QJsonObject item = m_dashboards.at(i).toObject();
+
+        if (!item.value("id").toString().isEmpty())
+            continue;
+
+        item.insert("id", QString(randomData(8).toHex()));
+        m_dashboards.replace(i, item);
+    }
+}
+
+QByteArray Database::data(void)
+{
+    QJsonObject json = {{"timestamp", QDateTime::currentSecsSinceEpoch()}, {"version", SERVICE_VERSION}, {"adminToken", adminToken()}, {"guestToken", guestToken()}};
+
+    if (!m_dashboards.isEmpty())
+        json.insert("dashboards", m_dashboards);
+
+    return QJsonDocument(json).toJson(QJsonDocument::Compact);
+}
+
+void Database::save(void)
+{
+    if (m_busy)
+    {
+        m_pending = true;
+        return;
+    }
+
+    m_busy = true;
+    emit storeRequest(data());
+}
+
 void Database::write(void)
 {
     QJsonObject json = {{"timestamp", QDateTime::currentSecsSinceEpoch()}, {"version", SERVICE_VERSION}};
-    QByteArray data;
-    bool check = true;
 
     if (!m_dashboards.isEmpty())
         json.insert("dashboards", m_dashboards);
@@ -80,27 +232,17 @@ void Database::write(void)
         return;
 
     m_sync = false;
+    save();
+}
 
-    if (!m_file.open(QFile::WriteOnly))
-    {
-        logWarning << "Database not stored, file" << m_file.fileName() << "open error:" << m_file.errorString();
-        return;
-    }
-
-    json.insert("adminToken", m_adminToken);
-    json.insert("guestToken", m_guestToken);
-    data = QJsonDocument(json).toJson(QJsonDocument::Compact);
-
-    if (m_file.write(data) != data.length())
-    {
-        logWarning << "Database not stored, file" << m_file.fileName() << "write error:" << m_file.errorString();
-        check = false;
-    }
-
-    m_file.close();
+void Database::finished(qint64 elapsed)
+{
+    m_metrics->databaseWrite(elapsed);
+    m_busy = false;
 
-    if (!check)
+    if (!m_pending)
         return;
 
-    system("sync");
+    m_pending = false;
+    save();
 }
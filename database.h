@@ -7,8 +7,33 @@
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QMutex>
 #include <QSettings>
+#include <QThread>
 #include <QTimer>
+#include "metrics.h"
+
+class DatabaseWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    DatabaseWriter(const QString &fileName) : m_fileName(fileName) {}
+
+private:
+
+    QString m_fileName;
+
+public slots:
+
+    void store(const QByteArray &data);
+
+signals:
+
+    void finished(qint64 elapsed);
+
+};
 
 class Database : public QObject
 {
@@ -16,38 +41,51 @@ class Database : public QObject
 
 public:
 
-    Database(QSettings *config, QObject *parent);
+    Database(QSettings *config, Metrics *metrics, QObject *parent);
     ~Database(void);
 
-    inline QString adminToken(void) { return m_adminToken; }
-    inline void resetAdminToken(void) { m_adminToken = randomData(32).toHex(); }
-
-    inline QString guestToken(void) { return m_guestToken; }
-    inline void resetGuestToken(void) { m_guestToken = randomData(32).toHex(); }
+    inline QString adminToken(void) { QMutexLocker lock(&m_mutex); return m_adminToken; }
+    inline void resetAdminToken(void) { QMutexLocker lock(&m_mutex); m_adminToken = randomData(32).toHex(); }
 
-    inline void update(const QJsonArray &data) { m_dashboards = data; }
+    inline QString guestToken(void) { QMutexLocker lock(&m_mutex); return m_guestToken; }
+    inline void resetGuestToken(void) { QMutexLocker lock(&m_mutex); m_guestToken = randomData(32).toHex(); }
 
     void init(void);
+    void update(const QJsonArray &data);
+    QJsonObject patch(const QJsonObject &json);
+
     void store(bool sync = false);
 
 private:
 
+    Metrics *m_metrics;
     QTimer *m_timer;
+    QThread *m_thread;
+    DatabaseWriter *m_writer;
+
     QFile m_file;
-    bool m_sync;
+    bool m_sync, m_busy, m_pending;
 
+    QMutex m_mutex;
     QString m_adminToken, m_guestToken;
     QJsonArray m_dashboards;
 
     QByteArray randomData(int length);
+    QByteArray data(void);
+
+    int dashboardIndex(const QString &id);
+    void identify(void);
+    void save(void);
 
 private slots:
 
     void write(void);
+    void finished(qint64 elapsed);
 
 signals:
 
     void statusUpdated(const QJsonObject &json);
+    void storeRequest(const QByteArray &data);
 
 };
 
@@ -1,4 +1,4 @@
-let modal, controller, guest = true, theme = localStorage.getItem('theme') ?? 'dark', wide = localStorage.getItem('wide') ?? 'off', empty = '<span class="shade">&bull;</span>';
+let modal, controller, bundle, guest = true, theme = localStorage.getItem('theme') ?? 'dark', wide = localStorage.getItem('wide') ?? 'off', empty = '<span class="shade">&bull;</span>';
 
 class Socket
 {
@@ -15,10 +15,15 @@ class Socket
 
     connect()
     {
+        this.cbor = false;
+        this.delta = false;
+        this.messages = new Object();
+        this.snapshots = new Object();
         this.ws = new WebSocket((location.protocol == 'https:' ? 'wss://' : 'ws://') + location.host + location.pathname);
 
+        this.ws.binaryType = 'arraybuffer';
         this.ws.onopen = function() { this.onopen(); this.connected = true; }.bind(this);
-        this.ws.onmessage = function(event) { let data = JSON.parse(event.data); this.onmessage(data.topic, data.message); }.bind(this);
+        this.ws.onmessage = function(event) { try { if (!(event.data instanceof ArrayBuffer)) this.parse(JSON.parse(event.data)); else if (this.cbor) this.parse(cborDecode(event.data)); else this.inflate.write(new Uint8Array(event.data)); } catch (error) { console.error(error); } }.bind(this);
         this.ws.onerror = function() { this.ws.close(); }.bind(this);
 
         this.ws.onclose = function()
@@ -35,23 +40,112 @@ class Socket
         }.bind(this);
     }
 
-    subscribe(topic)
+    parse(data)
+    {
+        (Array.isArray(data) ? data : [data]).forEach(item => { try { this.parseItem(item); } catch (error) { console.error(error); } });
+    }
+
+    parseItem(item)
+    {
+        if (item.topic == 'snapshot')
+        {
+            let messages = {...this.snapshots[item.filter], ...item.messages};
+
+            if (!item.end)
+            {
+                this.snapshots[item.filter] = messages;
+                return;
+            }
+
+            delete this.snapshots[item.filter];
+            this.parse(Object.keys(messages).map(topic => { return {'topic': topic, 'message': messages[topic]}; }));
+            return;
+        }
+
+        if (item.patch)
+        {
+            if (!this.messages[item.topic])
+            {
+                this.send({'action': 'resync', 'topic': item.topic});
+                return;
+            }
+
+            mergePatch(this.messages[item.topic], item.patch);
+            this.onmessage(item.topic, structuredClone(this.messages[item.topic]));
+            return;
+        }
+
+        if (this.delta && item.message && typeof item.message == 'object' && ['device', 'expose', 'service', 'status'].includes(item.topic.split('/')[0]))
+            this.messages[item.topic] = structuredClone(item.message);
+
+        this.onmessage(item.topic, item.message);
+    }
+
+    send(data)
+    {
+        this.ws.send(this.cbor ? cborEncode(data) : JSON.stringify(data));
+    }
+
+    setup(options)
+    {
+        if (options.deflate)
+        {
+            try
+            {
+                let stream = new DecompressionStream('deflate-raw');
+                let reader = stream.readable.pipeThrough(new TextDecoderStream()).getReader();
+                let buffer = '';
+
+                let read = function()
+                {
+                    reader.read().then(result =>
+                    {
+                        let list;
+
+                        if (result.done)
+                            return;
+
+                        list = (buffer + result.value).split('\0');
+                        buffer = list.pop();
+
+                        list.forEach(item => { try { this.parse(JSON.parse(item)); } catch (error) { console.error(error); } });
+                        read();
+                    });
+
+                }.bind(this);
+
+                this.inflate = stream.writable.getWriter();
+                read();
+            }
+            catch
+            {
+                delete options.deflate;
+            }
+        }
+
+        this.cbor = false;
+        this.send({...{'action': 'setup'}, ...options});
+        this.cbor = options.format == 'cbor';
+        this.delta = options.delta;
+    }
+
+    subscribe(topic, options = {})
     {
         if (!this.subscriptions.includes(topic))
             this.subscriptions.push(topic);
 
-        this.ws.send(JSON.stringify({'action': 'subscribe', 'topic': topic}));
+        this.send({...{'action': 'subscribe', 'topic': topic}, ...options});
     }
 
     publish(topic, message)
     {
-        this.ws.send(JSON.stringify({'action': 'publish', 'topic': topic, 'message': message}));
+        this.send({'action': 'publish', 'topic': topic, 'message': message});
     }
 
     unsubscribe(topic)
     {
         this.subscriptions.splice(this.subscriptions.indexOf(topic), 1);
-        this.ws.send(JSON.stringify({'action': 'unsubscribe', 'topic': topic}));
+        this.send({'action': 'unsubscribe', 'topic': topic});
     }
 }
 
@@ -65,6 +159,7 @@ class Controller
         console.log('socket successfully connected');
         this.socket.subscribe('service/#');
         this.socket.subscribe('status/web');
+        this.socket.subscribe('event/web');
     }
 
     onclose()
@@ -90,6 +185,12 @@ class Controller
         {
             guest = message.guest;
 
+            if (message.features)
+            {
+                let cbor = message.features.includes('cbor') && localStorage.getItem('format') == 'cbor';
+                this.socket.setup({'batch': message.features.includes('batch'), 'delta': message.features.includes('delta'), 'snapshot': message.features.includes('snapshot'), 'deflate': message.features.includes('deflate') && !cbor, 'format': cbor ? 'cbor' : 'json'});
+            }
+
             if (guest)
             {
                 document.querySelector('.header img').classList.remove('mobileHidden');
@@ -627,7 +728,7 @@ class DeviceService
 
     showDeviceInfo(device)
     {
-        fetch('html/' + this.service + '/deviceInfo.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/' + this.service + '/deviceInfo.html').then(html =>
         {
             let table;
 
@@ -669,7 +770,7 @@ class DeviceService
 
     showDeviceRemove(device)
     {
-        fetch('html/' + this.service + '/deviceRemove.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/' + this.service + '/deviceRemove.html').then(html =>
         {
             modal.querySelector('.data').innerHTML = html;
             modal.querySelector('.name').innerHTML = device.info.name;
@@ -693,7 +794,7 @@ window.onload = function()
 
     document.querySelector('#hotkeys').addEventListener('click', function()
     {
-        fetch('hotkeys.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('hotkeys.html').then(html =>
         {
             modal.querySelector('.data').innerHTML = html;
             modal.querySelector('.close').addEventListener('click', function() { showModal(false); });
@@ -715,7 +816,7 @@ window.onload = function()
 
     logout.addEventListener('click', function()
     {
-        fetch('logout.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('logout.html').then(html =>
         {
             modal.querySelector('.data').innerHTML = html;
             modal.querySelector('.current').addEventListener('click', function() { window.location.href = 'logout?session=current'; }.bind(this));
@@ -1020,4 +1121,151 @@ function loadFile(callback)
     input.setAttribute('type', 'file');
     input.setAttribute('accept', 'application/json');
     input.click();
-}
\ No newline at end of file
+}
+
+function fetchHtml(url)
+{
+    if (!bundle)
+        bundle = fetch('html/bundle.json').then(response => response.ok ? response.json() : new Object()).catch(() => new Object());
+
+    return bundle.then(data => data[url] ?? fetch(url + '?' + Date.now()).then(response => response.text()));
+}
+
+function mergePatch(target, patch)
+{
+    Object.keys(patch).forEach(key =>
+    {
+        if (patch[key] === null)
+        {
+            delete target[key];
+            return;
+        }
+
+        if (typeof patch[key] == 'object' && !Array.isArray(patch[key]))
+        {
+            if (typeof target[key] != 'object' || target[key] === null || Array.isArray(target[key]))
+                target[key] = new Object();
+
+            mergePatch(target[key], patch[key]);
+            return;
+        }
+
+        target[key] = patch[key];
+    });
+}
+
+function cborEncode(value)
+{
+    let data = new Array();
+    let encoder = new TextEncoder();
+
+    let head = function(type, length)
+    {
+        switch (true)
+        {
+            case length < 24:    data.push(type << 5 | length); break;
+            case length < 256:   data.push(type << 5 | 24, length); break;
+            case length < 65536: data.push(type << 5 | 25, length >> 8, length & 255); break;
+            default:             data.push(type << 5 | 26, length >>> 24 & 255, length >> 16 & 255, length >> 8 & 255, length & 255); break;
+        }
+    };
+
+    let encode = function(item)
+    {
+        switch (true)
+        {
+            case item === false: data.push(0xf4); break;
+            case item === true: data.push(0xf5); break;
+            case item === null || item === undefined: data.push(0xf6); break;
+            case typeof item == 'number' && Number.isInteger(item) && Math.abs(item) < 4294967296: if (item < 0) head(1, -1 - item); else head(0, item); break;
+            case typeof item == 'number': let view = new DataView(new ArrayBuffer(8)); view.setFloat64(0, item); data.push(0xfb, ...new Uint8Array(view.buffer)); break;
+            case typeof item == 'string': let bytes = encoder.encode(item); head(3, bytes.length); bytes.forEach(byte => { data.push(byte); }); break;
+            case Array.isArray(item): head(4, item.length); item.forEach(value => { encode(value); }); break;
+            default: let keys = Object.keys(item); head(5, keys.length); keys.forEach(key => { encode(key); encode(item[key]); }); break;
+        }
+    };
+
+    encode(value);
+    return new Uint8Array(data);
+}
+
+function cborDecode(buffer)
+{
+    let view = new DataView(buffer);
+    let decoder = new TextDecoder();
+    let offset = 0;
+
+    let length = function(info)
+    {
+        switch (info)
+        {
+            case 24: offset += 1; return view.getUint8(offset - 1);
+            case 25: offset += 2; return view.getUint16(offset - 2);
+            case 26: offset += 4; return view.getUint32(offset - 4);
+            case 27: offset += 8; return Number(view.getBigUint64(offset - 8));
+            case 31: return -1;
+            default: return info;
+        }
+    };
+
+    let half = function(value)
+    {
+        let exponent = value >> 10 & 31, fraction = value & 1023, sign = value & 32768 ? -1 : 1;
+
+        switch (exponent)
+        {
+            case 0:  return sign * Math.pow(2, -14) * fraction / 1024;
+            case 31: return fraction ? NaN : sign * Infinity;
+            default: return sign * Math.pow(2, exponent - 15) * (1 + fraction / 1024);
+        }
+    };
+
+    let decode = function()
+    {
+        let initial = view.getUint8(offset++), type = initial >> 5, info = initial & 31, count, data;
+
+        if (type == 7)
+        {
+            switch (info)
+            {
+                case 20: return false;
+                case 21: return true;
+                case 25: offset += 2; return half(view.getUint16(offset - 2));
+                case 26: offset += 4; return view.getFloat32(offset - 4);
+                case 27: offset += 8; return view.getFloat64(offset - 8);
+                default: return null;
+            }
+        }
+
+        count = length(info);
+
+        switch (type)
+        {
+            case 0: return count;
+            case 1: return -1 - count;
+            case 2: offset += count; return buffer.slice(offset - count, offset);
+            case 3: offset += count; return decoder.decode(new Uint8Array(buffer, offset - count, count));
+            case 6: return decode();
+        }
+
+        data = type == 4 ? new Array() : new Object();
+
+        for (let i = 0; count < 0 ? view.getUint8(offset) != 0xff : i < count; i++)
+        {
+            if (type == 4)
+            {
+                data.push(decode());
+                continue;
+            }
+
+            data[decode()] = decode();
+        }
+
+        if (count < 0)
+            offset++;
+
+        return data;
+    };
+
+    return decode();
+}
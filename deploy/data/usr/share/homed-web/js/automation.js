@@ -535,7 +535,7 @@ class Automation
 
     showStates()
     {
-        fetch('html/automation/states.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/automation/states.html').then(html =>
         {
             modal.querySelector('.data').innerHTML = html;
             modal.querySelector('.close').addEventListener('click', function() { showModal(false); });
@@ -552,7 +552,7 @@ class Automation
             return;
         }
 
-        fetch('html/automation/automationList.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/automation/automationList.html').then(html =>
         {
             let table;
             let count = 0;
@@ -607,7 +607,7 @@ class Automation
 
     showAutomationInfo(updated = true, add = false)
     {
-        fetch('html/automation/automationInfo.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/automation/automationInfo.html').then(html =>
         {
             let triggers;
             let conditions;
@@ -727,7 +727,7 @@ class Automation
 
     showAutomationEdit()
     {
-        fetch('html/automation/automationEdit.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/automation/automationEdit.html').then(html =>
         {
             modal.querySelector('.data').innerHTML = html;
             modal.querySelector('.name').innerHTML = this.data.name;
@@ -758,7 +758,7 @@ class Automation
 
     showAutomationRemove()
     {
-        fetch('html/automation/automationRemove.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/automation/automationRemove.html').then(html =>
         {
             modal.querySelector('.data').innerHTML = html;
             modal.querySelector('.name').innerHTML = this.data.name;
@@ -809,7 +809,7 @@ class Automation
 
     showPropertyItem(item, list, statements, append, type)
     {
-        fetch('html/automation/propertyItem.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/automation/propertyItem.html').then(html =>
         {
             let properties = this.controller.propertiesList();
             let data;
@@ -903,7 +903,7 @@ class Automation
 
     showMqttItem(item, list, statements, append, type)
     {
-        fetch('html/automation/mqttItem.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/automation/mqttItem.html').then(html =>
         {
             modal.querySelector('.data').innerHTML = html;
             modal.querySelector('.name').innerHTML = 'MQTT ' + type;
@@ -978,7 +978,7 @@ class Automation
 
     showTelegramTrigger(trigger, append)
     {
-        fetch('html/automation/telegramTrigger.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/automation/telegramTrigger.html').then(html =>
         {
             modal.querySelector('.data').innerHTML = html;
             modal.querySelector('textarea[name="message"]').value = trigger.message ?? '';
@@ -1014,7 +1014,7 @@ class Automation
 
     showTimeTrigger(trigger, append)
     {
-        fetch('html/automation/timeTrigger.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/automation/timeTrigger.html').then(html =>
         {
             modal.querySelector('.data').innerHTML = html;
             modal.querySelector('input[name="time"]').value = trigger.time ?? '12:00';
@@ -1047,7 +1047,7 @@ class Automation
 
     showIntervalTrigger(trigger, append)
     {
-        fetch('html/automation/intervalTrigger.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/automation/intervalTrigger.html').then(html =>
         {
             modal.querySelector('.data').innerHTML = html;
             modal.querySelector('input[name="interval"]').value = trigger.interval ?? '10';
@@ -1080,7 +1080,7 @@ class Automation
 
     showStatePatternCondition(condition, list, append, type)
     {
-        fetch('html/automation/' + type + 'Condition.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/automation/' + type + 'Condition.html').then(html =>
         {
             modal.querySelector('.data').innerHTML = html;
             modal.querySelector(type == 'state' ? 'input[name="name"]' : 'textarea[name="pattern"]').value = condition[type == 'state' ? 'name' : 'pattern'] ?? '';
@@ -1135,7 +1135,7 @@ class Automation
 
     showDateTimeCondition(condition, list, append, type)
     {
-        fetch('html/automation/' + type + 'Condition.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/automation/' + type + 'Condition.html').then(html =>
         {
             modal.querySelector('.data').innerHTML = html;
 
@@ -1186,7 +1186,7 @@ class Automation
 
     showWeekCondition(condition, list, append)
     {
-        fetch('html/automation/weekCondition.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/automation/weekCondition.html').then(html =>
         {
             modal.querySelector('.data').innerHTML = html;
             modal.querySelector('input[name="days"]').value = condition.days ? condition.days.join(', ') : '';
@@ -1214,7 +1214,7 @@ class Automation
 
     showMqttAction(action, list, append)
     {
-        fetch('html/automation/mqttAction.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/automation/mqttAction.html').then(html =>
         {
             modal.querySelector('.data').innerHTML = html;
             modal.querySelector('input[name="topic"]').value = action.topic ?? '';
@@ -1251,7 +1251,7 @@ class Automation
 
     showStateAction(action, list, append)
     {
-        fetch('html/automation/stateAction.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/automation/stateAction.html').then(html =>
         {
             modal.querySelector('.data').innerHTML = html;
             modal.querySelector('input[name="name"]').value = action.name ?? '';
@@ -1286,7 +1286,7 @@ class Automation
 
     showTelegramAction(action, list, append)
     {
-        fetch('html/automation/telegramAction.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/automation/telegramAction.html').then(html =>
         {
             modal.querySelector('.data').innerHTML = html;
             modal.querySelector('textarea[name="message"]').value = action.message ?? '';
@@ -1336,7 +1336,7 @@ class Automation
 
     showShellAction(action, list, append)
     {
-        fetch('html/automation/shellAction.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/automation/shellAction.html').then(html =>
         {
             modal.querySelector('.data').innerHTML = html;
             modal.querySelector('textarea[name="command"]').value = action.command ?? '';
@@ -1369,7 +1369,7 @@ class Automation
 
     showDelayAction(action, list, append)
     {
-        fetch('html/automation/delayAction.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/automation/delayAction.html').then(html =>
         {
             modal.querySelector('.data').innerHTML = html;
             modal.querySelector('textarea[name="delay"]').value = action.delay ?? '';
@@ -1402,7 +1402,7 @@ class Automation
 
     showAlert(page)
     {
-        fetch('html/automation/alert.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/automation/alert.html').then(html =>
         {
             modal.querySelector('.data').innerHTML = html;
             modal.querySelector('.name').innerHTML = this.data.name;
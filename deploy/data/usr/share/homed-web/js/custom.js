@@ -110,7 +110,7 @@ class Custom extends DeviceService
             return;
         }
 
-        fetch('html/custom/deviceList.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/custom/deviceList.html').then(html =>
         {
             let table;
             let count = 0;
@@ -170,7 +170,7 @@ class Custom extends DeviceService
             add = true;
         }
 
-        fetch('html/custom/deviceEdit.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/custom/deviceEdit.html').then(html =>
         {
             modal.querySelector('.data').innerHTML = html;
             modal.querySelector('.name').innerHTML = device.info.name;
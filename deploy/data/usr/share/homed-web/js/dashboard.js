@@ -32,6 +32,50 @@ class Dashboard
                 }
 
                 break;
+
+            case 'event':
+
+                if (!this.status.dashboards)
+                    break;
+
+                this.parseEvent(message);
+
+                if (this.controller.service == 'dashboard')
+                {
+                    this.controller.showPage('dashboard');
+                    this.updatePage();
+                }
+
+                break;
+        }
+    }
+
+    parseEvent(message)
+    {
+        let index = this.status.dashboards.findIndex(dashboard => dashboard.id == message.id);
+
+        switch (message.action)
+        {
+            case 'addDashboard':
+            case 'updateDashboard':
+
+                if (index < 0)
+                    this.status.dashboards.push(message.data);
+                else
+                    this.status.dashboards[index] = message.data;
+
+                break;
+
+            case 'removeDashboard':
+
+                if (index >= 0)
+                    this.status.dashboards.splice(index, 1);
+
+                break;
+
+            case 'reorderDashboards':
+                this.status.dashboards.sort((a, b) => message.ids.indexOf(a.id) - message.ids.indexOf(b.id));
+                break;
         }
     }
 
@@ -47,9 +91,32 @@ class Dashboard
         localStorage.setItem('dashboard', this.index);
     }
 
-    storeData()
+    storeData(action, dashboard)
     {
-        this.controller.socket.publish('command/web', {action: 'updateDashboards', data: this.status.dashboards});
+        let data = {action: action};
+
+        switch (action)
+        {
+            case 'addDashboard':
+                dashboard.id = Math.random().toString(16).slice(2);
+                data.data = dashboard;
+                break;
+
+            case 'updateDashboard':
+                data.id = dashboard.id;
+                data.data = dashboard;
+                break;
+
+            case 'removeDashboard':
+                data.id = dashboard.id;
+                break;
+
+            case 'reorderDashboards':
+                data.ids = this.status.dashboards.map(item => item.id);
+                break;
+        }
+
+        this.controller.socket.publish('command/web', data);
         this.controller.clearPage();
     }
 
@@ -158,7 +225,7 @@ class Dashboard
                 {
                     this.status.dashboards.push(data);
                     this.setIndex(this.status.dashboards.length - 1);
-                    this.storeData();
+                    this.storeData('addDashboard', data);
 
                 }.bind(this));
 
@@ -188,7 +255,7 @@ class Dashboard
         if (!guest)
             document.querySelector('#sort').style.display = this.status.dashboards.length > 1 ? 'inline-block' : 'none';
 
-        fetch('html/dashboard/dashboard.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/dashboard/dashboard.html').then(html =>
         {
             let list;
             let dashboard;
@@ -389,10 +456,10 @@ class Dashboard
 
         }.bind(this);
 
-        fetch('html/dashboard/dashboardSort.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/dashboard/dashboardSort.html').then(html =>
         {
             modal.querySelector('.data').innerHTML = html;
-            modal.querySelector('.save').addEventListener('click', function() { this.storeData(); }.bind(this));
+            modal.querySelector('.save').addEventListener('click', function() { this.storeData('reorderDashboards'); }.bind(this));
             modal.querySelector('.cancel').addEventListener('click', function() { showModal(false); });
 
             showTable(modal.querySelector('table.dashboards'));
@@ -457,7 +524,7 @@ class Dashboard
         if (!dashboard)
             dashboard = {name: 'New dashboard', blocks: new Array(), add: true};
 
-        fetch('html/dashboard/dashboardEdit.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/dashboard/dashboardEdit.html').then(html =>
         {
             modal.querySelector('.data').innerHTML = html;
             modal.querySelector('.name').innerHTML = dashboard.name;
@@ -466,6 +533,8 @@ class Dashboard
 
             modal.querySelector('.save').addEventListener('click', function()
             {
+                let action = dashboard.add ? 'addDashboard' : 'updateDashboard';
+
                 dashboard.name = modal.querySelector('input[name="name"]').value;
 
                 if (dashboard.add)
@@ -475,7 +544,7 @@ class Dashboard
                     delete dashboard.add;
                 }
 
-                this.storeData();
+                this.storeData(action, dashboard);
 
             }.bind(this));
 
@@ -488,11 +557,11 @@ class Dashboard
 
     showDashboardRemove(dashboard)
     {
-        fetch('html/dashboard/dashboardRemove.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/dashboard/dashboardRemove.html').then(html =>
         {
             modal.querySelector('.data').innerHTML = html;
             modal.querySelector('.name').innerHTML = dashboard.name;
-            modal.querySelector('.remove').addEventListener('click', function() { this.status.dashboards.splice(this.index, 1); this.setIndex(0); this.storeData(); }.bind(this));
+            modal.querySelector('.remove').addEventListener('click', function() { this.status.dashboards.splice(this.index, 1); this.setIndex(0); this.storeData('removeDashboard', dashboard); }.bind(this));
             modal.querySelector('.cancel').addEventListener('click', function() { showModal(false); });
             showModal(true);
         });
@@ -555,7 +624,7 @@ class Dashboard
         if (!block)
             block = {name: 'New block', items: new Array(), add: true};
 
-        fetch('html/dashboard/blockEdit.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/dashboard/blockEdit.html').then(html =>
         {
             modal.querySelector('.data').innerHTML = html;
             modal.querySelector('.name').innerHTML = dashboard.name + ' <i class="icon-right"></i> ' + block.name;
@@ -580,7 +649,7 @@ class Dashboard
                     return;
                 }
 
-                this.storeData();
+                this.storeData('updateDashboard', dashboard);
 
             }.bind(this));
 
@@ -638,7 +707,7 @@ class Dashboard
             });
         }
 
-        fetch('html/dashboard/itemEdit.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/dashboard/itemEdit.html').then(html =>
         {
             let data;
 
@@ -693,7 +762,7 @@ class Dashboard
                     return;
                 }
 
-                this.storeData();
+                this.storeData('updateDashboard', dashboard);
 
             }.bind(this));
 
@@ -727,7 +796,7 @@ class Dashboard
                 expose += '_' + part[1];
         }
 
-        fetch('html/dashboard/exposeInfo.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/dashboard/exposeInfo.html').then(html =>
         {
             let table;
 
@@ -753,7 +822,7 @@ class Dashboard
 
     showRecorderInfo(item, interval)
     {
-        fetch('html/dashboard/recorderInfo.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/dashboard/recorderInfo.html').then(html =>
         {
             let id = 'chart-' + randomString(8);
             let chart;
@@ -114,7 +114,7 @@ class Modbus extends DeviceService
             return;
         }
 
-        fetch('html/modbus/deviceList.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/modbus/deviceList.html').then(html =>
         {
             let table;
             let count = 0;
@@ -174,7 +174,7 @@ class Modbus extends DeviceService
             add = true;
         }
 
-        fetch('html/modbus/deviceEdit.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/modbus/deviceEdit.html').then(html =>
         {
             modal.querySelector('.data').innerHTML = html;
             modal.querySelector('.name').innerHTML = device.info.name;
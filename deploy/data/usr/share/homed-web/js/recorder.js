@@ -123,7 +123,7 @@ class Recorder
             canvas.dataset.end = Date.now();
         }
 
-        this.controller.socket.publish('command/recorder', {action: 'getData', id: canvas.id, endpoint: canvas.dataset.endpoint, property: canvas.dataset.property, start: canvas.dataset.start, end: canvas.dataset.end});
+        this.controller.socket.publish('command/recorder', {action: 'getData', id: canvas.id, endpoint: canvas.dataset.endpoint, property: canvas.dataset.property, start: canvas.dataset.start, end: canvas.dataset.end, interval: canvas.dataset.interval, width: canvas.clientWidth});
     }
 
     chartQuery(item, element, interval, start, end)
@@ -161,7 +161,7 @@ class Recorder
             return;
 
         if (status)
-            status.innerHTML = message.timestamp.length + ' records, ' + message.time + ' ms';
+            status.innerHTML = (message.records ?? message.timestamp.length) + ' records, ' + message.time + ' ms';
 
         if (!message.timestamp.length)
         {
@@ -467,7 +467,7 @@ class Recorder
             return;
         }
 
-        fetch('html/recorder/itemList.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/recorder/itemList.html').then(html =>
         {
             let table;
             let count = 0;
@@ -506,7 +506,7 @@ class Recorder
 
     showItemInfo()
     {
-        fetch('html/recorder/itemInfo.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/recorder/itemInfo.html').then(html =>
         {
             let start = localStorage.getItem('recorderStart');
             let end = localStorage.getItem('recorderEnd');
@@ -592,7 +592,7 @@ class Recorder
 
     showItemEdit(add = false)
     {
-        fetch('html/recorder/itemEdit.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/recorder/itemEdit.html').then(html =>
         {
             let name;
             let data;
@@ -660,7 +660,7 @@ class Recorder
 
     showItemRemove()
     {
-        fetch('html/recorder/itemRemove.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/recorder/itemRemove.html').then(html =>
         {
             let name;
 
@@ -263,7 +263,7 @@ class ZigBee extends DeviceService
 
     showDeviceList()
     {
-        fetch('html/zigbee/deviceList.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/zigbee/deviceList.html').then(html =>
         {
             let table;
             let count = 0;
@@ -324,7 +324,7 @@ class ZigBee extends DeviceService
 
     showDeviceMap()
     {
-        fetch('html/zigbee/deviceMap.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/zigbee/deviceMap.html').then(html =>
         {
             let map, width, height, link, text, node, routerLinks = false;
             let data = {nodes: new Array(), links: new Array()};
@@ -399,7 +399,7 @@ class ZigBee extends DeviceService
 
     showDeviceInfo(device)
     {
-        fetch('html/zigbee/deviceInfo.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/zigbee/deviceInfo.html').then(html =>
         {
             let table;
             let ota;
@@ -449,7 +449,7 @@ class ZigBee extends DeviceService
         if (!device.info.logicalType)
             return;
 
-        fetch('html/zigbee/deviceEdit.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/zigbee/deviceEdit.html').then(html =>
         {
             modal.querySelector('.data').innerHTML = html;
             modal.querySelector('.name').innerHTML = device.info.name;
@@ -469,7 +469,7 @@ class ZigBee extends DeviceService
         if (!device.info.logicalType)
             return;
 
-        fetch('html/zigbee/deviceRemove.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/zigbee/deviceRemove.html').then(html =>
         {
             let item = this.names ? device.info.name : device.id;
             modal.querySelector('.data').innerHTML = html;
@@ -486,7 +486,7 @@ class ZigBee extends DeviceService
         if (!device.info.logicalType)
             return;
 
-        fetch('html/zigbee/deviceUpgrade.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/zigbee/deviceUpgrade.html').then(html =>
         {
             let item = this.names ? device.info.name : device.id;
 
@@ -505,7 +505,7 @@ class ZigBee extends DeviceService
 
     showDeviceData(device)
     {
-        fetch('html/zigbee/deviceData.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/zigbee/deviceData.html').then(html =>
         {
             modal.querySelector('.data').innerHTML = html;
             modal.querySelector('.name').innerHTML = device.info.name;
@@ -517,7 +517,7 @@ class ZigBee extends DeviceService
 
     showDeviceDebug(device)
     {
-        fetch('html/zigbee/deviceDebug.html?' + Date.now()).then(response => response.text()).then(html =>
+        fetchHtml('html/zigbee/deviceDebug.html').then(html =>
         {
             let list;
             
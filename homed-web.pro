@@ -1,11 +1,36 @@
 include(../homed-common/homed-common.pri)
 
 HEADERS += \
+    assets.h \
+    client.h \
     controller.h \
-    database.h
+    database.h \
+    http.h \
+    metrics.h \
+    recorder.h \
+    retained.h \
+    subscriptions.h \
+    worker.h
 
 SOURCES += \
+    assets.cpp \
+    client.cpp \
     controller.cpp \
-    database.cpp
+    database.cpp \
+    http.cpp \
+    metrics.cpp \
+    recorder.cpp \
+    retained.cpp \
+    subscriptions.cpp \
+    worker.cpp
 
 QT += websockets
+
+LIBS += -lz
+
+CONFIG += link_pkgconfig
+
+packagesExist(libbrotlienc) {
+    DEFINES += BROTLI_ENABLED
+    PKGCONFIG += libbrotlienc
+}
@@ -0,0 +1,186 @@
+#include <QUrl>
+#include <string.h>
+#include "http.h"
+
+bool ConnectionObject::parse(void)
+{
+    if (!m_elapsed.isValid() && m_socket->bytesAvailable())
+        m_elapsed.start();
+
+    if (m_status == Status::Header)
+    {
+        QByteArray data = m_socket->peek(m_headerLimit);
+        int index = data.indexOf("\r\n\r\n", static_cast <int> (qMax <qint64> (m_offset - 3, 0)));
+
+        if (index < 0)
+        {
+            if (data.length() >= m_headerLimit)
+            {
+                m_status = Status::Error;
+                return true;
+            }
+
+            m_offset = data.length();
+            return false;
+        }
+
+        m_requests++;
+
+        if (!parseHeader(data.left(index)))
+        {
+            m_status = Status::Error;
+            return true;
+        }
+
+        if (m_headers.value("upgrade").toLower() == "websocket")
+        {
+            m_status = Status::Upgrade;
+            return true;
+        }
+
+        m_socket->read(index + 4);
+        m_length = m_headers.value("content-length").toLongLong();
+
+        if (m_length < 0 || m_length > m_contentLimit)
+        {
+            m_status = Status::Error;
+            return true;
+        }
+
+        m_status = m_length ? Status::Content : Status::Ready;
+    }
+
+    if (m_status == Status::Content)
+    {
+        m_content.append(m_socket->read(m_length - m_content.length()));
+
+        if (m_content.length() < m_length)
+            return false;
+
+        m_status = Status::Ready;
+    }
+
+    return true;
+}
+
+void ConnectionObject::reset(void)
+{
+    m_status = Status::Header;
+
+    m_method.clear();
+    m_url.clear();
+    m_version.clear();
+    m_content.clear();
+    m_headers.clear();
+
+    m_offset = 0;
+    m_length = 0;
+
+    m_elapsed.invalidate();
+}
+
+void ConnectionObject::setStream(const QByteArray &data, const QSharedPointer <QFile> &file)
+{
+    m_stream = data;
+    m_file = file;
+    m_streamOffset = 0;
+}
+
+bool ConnectionObject::writeStream(void)
+{
+    while (m_streamOffset < m_stream.length() && m_socket->bytesToWrite() < HTTP_STREAM_CHUNK)
+    {
+        qint64 length = qMin <qint64> (HTTP_STREAM_CHUNK, m_stream.length() - m_streamOffset);
+
+        if (m_socket->write(m_stream.constData() + m_streamOffset, length) < 0)
+            break;
+
+        m_streamOffset += length;
+    }
+
+    if (m_streamOffset < m_stream.length() && m_socket->state() == QAbstractSocket::ConnectedState)
+        return false;
+
+    m_stream.clear();
+    m_file.clear();
+    m_streamOffset = 0;
+    return true;
+}
+
+QString ConnectionObject::path(void)
+{
+    return QString(m_url.left(m_url.indexOf('?')));
+}
+
+QString ConnectionObject::cookie(const QByteArray &name)
+{
+    QByteArray data = m_headers.value("cookie");
+    int index = 0;
+
+    while (index < data.length())
+    {
+        int end = data.indexOf(';', index);
+
+        while (index < data.length() && data.at(index) == ' ')
+            index++;
+
+        if (end < 0)
+            end = data.length();
+
+        if (end - index > name.length() && data.at(index + name.length()) == '=' && !memcmp(data.constData() + index, name.constData(), name.length()))
+            return QString(data.mid(index + name.length() + 1, end - index - name.length() - 1).trimmed());
+
+        index = end + 1;
+    }
+
+    return QString();
+}
+
+QMap <QString, QString> ConnectionObject::items(void)
+{
+    return parseList(m_method == "GET" && m_url.contains('?') ? m_url.mid(m_url.indexOf('?') + 1) : m_content, '&', true);
+}
+
+bool ConnectionObject::parseHeader(const QByteArray &data)
+{
+    QList <QByteArray> list = data.split('\n'), target = list.value(0).trimmed().split(0x20);
+
+    if (target.count() != 3)
+        return false;
+
+    m_method = target.at(0);
+    m_url = target.at(1);
+    m_version = target.at(2);
+
+    for (int i = 1; i < list.count(); i++)
+    {
+        const QByteArray &line = list.at(i);
+        int index = line.indexOf(':');
+
+        if (index <= 0)
+            continue;
+
+        m_headers.insert(line.left(index).trimmed().toLower(), line.mid(index + 1).trimmed());
+    }
+
+    return true;
+}
+
+QMap <QString, QString> ConnectionObject::parseList(const QByteArray &data, char separator, bool decode)
+{
+    QList <QByteArray> list = data.split(separator);
+    QMap <QString, QString> map;
+
+    for (int i = 0; i < list.count(); i++)
+    {
+        const QByteArray &item = list.at(i);
+        int index = item.indexOf('=');
+
+        if (index <= 0)
+            continue;
+
+        map.insert(QString(item.left(index).trimmed()), decode ? QUrl::fromPercentEncoding(item.mid(index + 1)) : QString(item.mid(index + 1).trimmed()));
+    }
+
+    return map;
+}
@@ -0,0 +1,89 @@
+#ifndef HTTP_H
+#define HTTP_H
+
+#define HTTP_MAX_HEADER_SIZE    16384
+#define HTTP_MAX_CONTENT_SIZE   65536
+#define HTTP_STREAM_CHUNK       65536
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMap>
+#include <QSharedPointer>
+#include <QTcpSocket>
+
+class ConnectionObject
+{
+
+public:
+
+    enum class Status
+    {
+        Header,
+        Content,
+        Ready,
+        Upgrade,
+        Error
+    };
+
+    ConnectionObject(QTcpSocket *socket, qint64 headerLimit = HTTP_MAX_HEADER_SIZE, qint64 contentLimit = HTTP_MAX_CONTENT_SIZE) : m_socket(socket), m_address(socket->peerAddress().toString()), m_status(Status::Header), m_headerLimit(headerLimit), m_contentLimit(contentLimit), m_offset(0), m_length(0), m_expire(-1), m_requests(0), m_streamOffset(0), m_keepAlive(false) {}
+
+    inline QTcpSocket *socket(void) { return m_socket; }
+    inline QString address(void) { return m_address; }
+    inline Status status(void) { return m_status; }
+
+    inline QByteArray method(void) { return m_method; }
+    inline QByteArray url(void) { return m_url; }
+    inline QByteArray version(void) { return m_version; }
+    inline QByteArray content(void) { return m_content; }
+
+    inline QMap <QByteArray, QByteArray> headers(void) { return m_headers; }
+    inline QByteArray header(const QByteArray &name) { return m_headers.value(name); }
+
+    inline qint64 elapsed(void) { return m_elapsed.isValid() ? m_elapsed.nsecsElapsed() / 1000 : 0; }
+    inline bool idle(void) { return !m_elapsed.isValid(); }
+    inline quint32 requests(void) { return m_requests; }
+    inline bool keepAlive(void) { return m_keepAlive; }
+    inline void setKeepAlive(bool value) { m_keepAlive = value; }
+
+    inline qint64 expire(void) { return m_expire; }
+    inline void setExpire(qint64 value) { m_expire = value; }
+
+    inline bool streaming(void) { return !m_stream.isEmpty(); }
+
+    bool parse(void);
+    void reset(void);
+
+    void setStream(const QByteArray &data, const QSharedPointer <QFile> &file);
+    bool writeStream(void);
+
+    QString path(void);
+    QString cookie(const QByteArray &name);
+    QMap <QString, QString> items(void);
+
+private:
+
+    QTcpSocket *m_socket;
+    QString m_address;
+    Status m_status;
+
+    QByteArray m_method, m_url, m_version, m_content;
+    QMap <QByteArray, QByteArray> m_headers;
+    qint64 m_headerLimit, m_contentLimit, m_offset, m_length, m_expire;
+    QElapsedTimer m_elapsed;
+
+    quint32 m_requests;
+
+    QByteArray m_stream;
+    QSharedPointer <QFile> m_file;
+    qint64 m_streamOffset;
+
+    bool m_keepAlive;
+
+    bool parseHeader(const QByteArray &data);
+    QMap <QString, QString> parseList(const QByteArray &data, char separator, bool decode);
+
+};
+
+typedef QSharedPointer <ConnectionObject> Connection;
+
+#endif
@@ -0,0 +1,122 @@
+#include "metrics.h"
+
+static const qint64 bucketBounds[METRICS_BUCKETS] = {100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 1000000};
+
+Histogram::Histogram(void) : m_sum(0), m_count(0) {}
+
+void Histogram::observe(qint64 value)
+{
+    for (int i = 0; i < METRICS_BUCKETS; i++)
+        if (value <= bucketBounds[i])
+            m_buckets[i]++;
+
+    m_sum += static_cast <quint64> (qMax <qint64> (value, 0));
+    m_count++;
+}
+
+QByteArray Histogram::text(const QByteArray &name, const QByteArray &labels)
+{
+    QByteArray data, prefix, suffix;
+    quint64 count = m_count.loadRelaxed();
+
+    if (!labels.isEmpty())
+    {
+        prefix = QByteArray(labels).append(',');
+        suffix = QByteArray("{").append(labels).append('}');
+    }
+
+    for (int i = 0; i < METRICS_BUCKETS; i++)
+        data.append(QByteArray(name).append("_bucket{").append(prefix).append("le=\"").append(QByteArray::number(bucketBounds[i] / 1e6)).append("\"} ").append(QByteArray::number(m_buckets[i].loadRelaxed())).append('\n'));
+
+    data.append(QByteArray(name).append("_bucket{").append(prefix).append("le=\"+Inf\"} ").append(QByteArray::number(count)).append('\n'));
+    data.append(QByteArray(name).append("_sum").append(suffix).append(' ').append(QByteArray::number(m_sum.loadRelaxed() / 1e6)).append('\n'));
+    data.append(QByteArray(name).append("_count").append(suffix).append(' ').append(QByteArray::number(count)).append('\n'));
+
+    return data;
+}
+
+Metrics::Metrics(void) : m_mqttMessages(0), m_mqttLast(0), m_mqttRate(0), m_frames(0), m_frameBytes(0), m_rejected(0), m_timeouts(0), m_queue(0), m_messageBytes(0), m_sockets(0), m_clients(0), m_messages(0)
+{
+    QList <quint16> codes = {200, 301, 304, 400, 404, 405, 500, 503};
+    QList <QByteArray> types = {"device", "expose", "fd", "service", "status", "td", "other"};
+
+    for (int i = 0; i < codes.count(); i++)
+        m_requests.insert(codes.at(i), new Histogram);
+
+    for (int i = 0; i < types.count(); i++)
+    {
+        m_traceWrite.insert(types.at(i), new Histogram);
+        m_traceFlush.insert(types.at(i), new Histogram);
+    }
+}
+
+Metrics::~Metrics(void)
+{
+    qDeleteAll(m_requests);
+    qDeleteAll(m_traceWrite);
+    qDeleteAll(m_traceFlush);
+}
+
+void Metrics::httpRequest(quint16 code, qint64 elapsed)
+{
+    Histogram *histogram = m_requests.value(code);
+
+    if (!histogram)
+        return;
+
+    histogram->observe(elapsed);
+}
+
+void Metrics::update(int clients, int messages, qint64 messageBytes, qint64 queue, qint64 interval)
+{
+    quint64 count = m_mqttMessages.loadRelaxed();
+
+    if (interval > 0)
+        m_mqttRate.storeRelaxed((count - m_mqttLast.loadRelaxed()) * 1000 / static_cast <quint64> (interval));
+
+    m_mqttLast.storeRelaxed(count);
+    m_clients.storeRelaxed(clients);
+    m_messages.storeRelaxed(messages);
+    m_messageBytes.storeRelaxed(messageBytes);
+    m_queue.storeRelaxed(queue);
+}
+
+QByteArray Metrics::text(void)
+{
+    QByteArray data = "# TYPE homed_web_http_request_duration_seconds histogram\n";
+
+    for (auto it = m_requests.begin(); it != m_requests.end(); it++)
+        data.append(it.value()->text("homed_web_http_request_duration_seconds", QByteArray("code=\"").append(QByteArray::number(it.key())).append('"')));
+
+    data.append(metric("homed_web_http_connections", "gauge", m_sockets.loadRelaxed()));
+    data.append(metric("homed_web_http_rejected_total", "counter", m_rejected.loadRelaxed()));
+    data.append(metric("homed_web_http_timeouts_total", "counter", m_timeouts.loadRelaxed()));
+    data.append(metric("homed_web_websocket_clients", "gauge", m_clients.loadRelaxed()));
+    data.append(metric("homed_web_websocket_queue_bytes", "gauge", m_queue.loadRelaxed()));
+    data.append(metric("homed_web_mqtt_messages_total", "counter", m_mqttMessages.loadRelaxed()));
+    data.append(metric("homed_web_mqtt_messages_per_second", "gauge", m_mqttRate.loadRelaxed()));
+    data.append(metric("homed_web_frames_sent_total", "counter", m_frames.loadRelaxed()));
+    data.append(metric("homed_web_frame_bytes_sent_total", "counter", m_frameBytes.loadRelaxed()));
+    data.append(metric("homed_web_retained_messages", "gauge", m_messages.loadRelaxed()));
+    data.append(metric("homed_web_retained_bytes", "gauge", m_messageBytes.loadRelaxed()));
+
+    data.append("# TYPE homed_web_database_write_duration_seconds histogram\n");
+    data.append(m_database.text("homed_web_database_write_duration_seconds"));
+
+    data.append("# TYPE homed_web_trace_write_seconds histogram\n");
+
+    for (auto it = m_traceWrite.begin(); it != m_traceWrite.end(); it++)
+        data.append(it.value()->text("homed_web_trace_write_seconds", QByteArray("class=\"").append(it.key()).append('"')));
+
+    data.append("# TYPE homed_web_trace_flush_seconds histogram\n");
+
+    for (auto it = m_traceFlush.begin(); it != m_traceFlush.end(); it++)
+        data.append(it.value()->text("homed_web_trace_flush_seconds", QByteArray("class=\"").append(it.key()).append('"')));
+
+    return data;
+}
+
+QByteArray Metrics::metric(const QByteArray &name, const QByteArray &type, qint64 value)
+{
+    return QByteArray("# TYPE ").append(name).append(' ').append(type).append('\n').append(name).append(' ').append(QByteArray::number(value)).append('\n');
+}
@@ -0,0 +1,69 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#define METRICS_BUCKETS     11
+#define METRICS_INTERVAL    1000
+
+#include <QAtomicInteger>
+#include <QMap>
+
+class Histogram
+{
+
+public:
+
+    Histogram(void);
+
+    void observe(qint64 value);
+    QByteArray text(const QByteArray &name, const QByteArray &labels = QByteArray());
+
+private:
+
+    QAtomicInteger <quint64> m_buckets[METRICS_BUCKETS], m_sum, m_count;
+
+    Q_DISABLE_COPY(Histogram)
+
+};
+
+class Metrics
+{
+
+public:
+
+    Metrics(void);
+    ~Metrics(void);
+
+    void httpRequest(quint16 code, qint64 elapsed);
+
+    inline void socketOpened(void) { m_sockets++; }
+    inline void socketClosed(void) { m_sockets--; }
+    inline void socketRejected(void) { m_rejected++; }
+    inline void socketTimeout(void) { m_timeouts++; }
+
+    inline void mqttReceived(void) { m_mqttMessages++; }
+    inline void frameSent(qint64 bytes) { m_frames++; m_frameBytes += bytes; }
+    inline void databaseWrite(qint64 elapsed) { m_database.observe(elapsed); }
+
+    inline void traceWrite(const QByteArray &type, qint64 elapsed) { m_traceWrite.value(type, m_traceWrite.value("other"))->observe(elapsed); }
+    inline void traceFlush(const QByteArray &type, qint64 elapsed) { m_traceFlush.value(type, m_traceFlush.value("other"))->observe(elapsed); }
+
+    void update(int clients, int messages, qint64 messageBytes, qint64 queue, qint64 interval);
+    QByteArray text(void);
+
+private:
+
+    QMap <quint16, Histogram*> m_requests;
+    QMap <QByteArray, Histogram*> m_traceWrite, m_traceFlush;
+    Histogram m_database;
+
+    QAtomicInteger <quint64> m_mqttMessages, m_mqttLast, m_mqttRate, m_frames, m_frameBytes, m_rejected, m_timeouts;
+    QAtomicInteger <qint64> m_queue, m_messageBytes;
+    QAtomicInteger <int> m_sockets, m_clients, m_messages;
+
+    QByteArray metric(const QByteArray &name, const QByteArray &type, qint64 value);
+
+    Q_DISABLE_COPY(Metrics)
+
+};
+
+#endif
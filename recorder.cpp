@@ -0,0 +1,165 @@
+#include <QDateTime>
+#include <QJsonDocument>
+#include <algorithm>
+#include "recorder.h"
+
+QJsonObject RecorderProxy::request(const QJsonObject &json)
+{
+    QString id = json.value("id").toString(), interval = json.value("interval").toString(), key;
+    qint64 time = QDateTime::currentMSecsSinceEpoch(), start = json.value("start").toVariant().toLongLong(), end = json.value("end").toVariant().toLongLong();
+    int width = json.value("width").toInt();
+
+    if (!interval.isEmpty() && interval != "custom" && width > 0 && end > start)
+    {
+        qint64 bucket = qMax <qint64> ((end - start) / width, 1);
+        key = QString("%1/%2/%3/%4/%5").arg(json.value("endpoint").toString(), json.value("property").toString(), interval).arg(end / bucket).arg(width);
+    }
+    else
+        key = QString("%1/%2/%3/%4/%5").arg(json.value("endpoint").toString(), json.value("property").toString()).arg(start).arg(end).arg(width);
+
+    if (m_cache.contains(key))
+    {
+        RecorderCache cache = m_cache.value(key);
+
+        if (time - cache.time < RECORDER_CACHE_TTL)
+        {
+            QJsonObject message = cache.message;
+            message.insert("id", id);
+            return message;
+        }
+
+        m_cache.remove(key);
+        m_order.removeAll(key);
+    }
+
+    for (auto it = m_requests.begin(); it != m_requests.end();)
+    {
+        if (time - it.value().time < RECORDER_TIMEOUT)
+        {
+            it++;
+            continue;
+        }
+
+        it = m_requests.erase(it);
+    }
+
+    if (m_requests.contains(id))
+    {
+        RecorderRequest &request = m_requests[id];
+
+        request.key.clear();
+        request.width = width;
+        request.time = time;
+        request.count++;
+
+        return QJsonObject();
+    }
+
+    m_requests.insert(id, {key, width, time, 1});
+    return QJsonObject();
+}
+
+QByteArray RecorderProxy::response(const QByteArray &message)
+{
+    QJsonObject json;
+    RecorderRequest request;
+
+    if (m_requests.isEmpty())
+        return message;
+
+    json = QJsonDocument::fromJson(message).object();
+
+    if (!m_requests.contains(json.value("id").toString()))
+        return message;
+
+    request = m_requests.value(json.value("id").toString());
+
+    if (--m_requests[json.value("id").toString()].count <= 0)
+        m_requests.remove(json.value("id").toString());
+
+    if (!downsample(json, request.width))
+        return message;
+
+    if (request.key.isEmpty())
+        return QJsonDocument(json).toJson(QJsonDocument::Compact);
+
+    m_cache.insert(request.key, {json, QDateTime::currentMSecsSinceEpoch()});
+    m_order.removeAll(request.key);
+    m_order.append(request.key);
+
+    while (m_order.count() > RECORDER_CACHE_SIZE)
+        m_cache.remove(m_order.takeFirst());
+
+    return QJsonDocument(json).toJson(QJsonDocument::Compact);
+}
+
+bool RecorderProxy::downsample(QJsonObject &json, int width)
+{
+    QJsonArray timestamp = json.value("timestamp").toArray(), value = json.value("value").toArray(), timestampList, valueList;
+    QVector <double> numbers;
+    qint64 start, end;
+    int index = 0;
+
+    if (width <= 0 || timestamp.count() != value.count() || timestamp.count() <= width * RECORDER_POINTS)
+        return false;
+
+    numbers.resize(value.count());
+
+    for (int i = 0; i < value.count(); i++)
+    {
+        QJsonValue item = value.at(i);
+        bool check = true;
+
+        if (item.isNull())
+            continue;
+
+        numbers[i] = item.isDouble() ? item.toDouble() : item.toString().toDouble(&check);
+
+        if (!check)
+            return false;
+    }
+
+    start = static_cast <qint64> (timestamp.first().toDouble());
+    end = static_cast <qint64> (timestamp.last().toDouble());
+
+    while (index < timestamp.count())
+    {
+        qint64 bucket = (static_cast <qint64> (timestamp.at(index).toDouble()) - start) * width / (end - start + 1);
+        int min = -1, max = -1, last = -1;
+        QList <int> list = {index};
+
+        for (; index < timestamp.count() && (static_cast <qint64> (timestamp.at(index).toDouble()) - start) * width / (end - start + 1) == bucket; index++)
+        {
+            if (value.at(index).isNull())
+            {
+                list.append(index);
+                continue;
+            }
+
+            if (min < 0 || numbers.at(index) < numbers.at(min))
+                min = index;
+
+            if (max < 0 || numbers.at(index) > numbers.at(max))
+                max = index;
+
+            last = index;
+        }
+
+        list.append({min, max, last});
+        std::sort(list.begin(), list.end());
+
+        for (int j = 0; j < list.count(); j++)
+        {
+            if (list.at(j) < 0 || (j && list.at(j) == list.at(j - 1)))
+                continue;
+
+            timestampList.append(timestamp.at(list.at(j)));
+            valueList.append(value.at(list.at(j)));
+        }
+    }
+
+    json.insert("timestamp", timestampList);
+    json.insert("value", valueList);
+    json.insert("records", timestamp.count());
+    return true;
+}
@@ -0,0 +1,45 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#define RECORDER_CACHE_SIZE     16
+#define RECORDER_TIMEOUT        60000
+#define RECORDER_CACHE_TTL      10000
+#define RECORDER_POINTS         4
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QMap>
+
+struct RecorderRequest
+{
+    QString key;
+    int width;
+    qint64 time;
+    int count;
+};
+
+struct RecorderCache
+{
+    QJsonObject message;
+    qint64 time;
+};
+
+class RecorderProxy
+{
+
+public:
+
+    QJsonObject request(const QJsonObject &json);
+    QByteArray response(const QByteArray &message);
+
+private:
+
+    QMap <QString, RecorderRequest> m_requests;
+    QMap <QString, RecorderCache> m_cache;
+    QList <QString> m_order;
+
+    bool downsample(QJsonObject &json, int width);
+
+};
+
+#endif
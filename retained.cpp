@@ -0,0 +1,235 @@
+#include <QDataStream>
+#include "retained.h"
+#include "subscriptions.h"
+
+void RetainedCache::insert(const QString &topic, const QString &frame)
+{
+    auto it = m_messages.find(topic);
+    QString header = QString("{\"topic\":\"").append(topic).append("\",\"message\":");
+    RetainedEntry entry;
+
+    entry.full = !frame.startsWith(header);
+    entry.data = entry.full ? frame.toUtf8() : frame.mid(header.length(), frame.length() - header.length() - 1).toUtf8();
+    entry.compressed = entry.data.length() > RETAINED_COMPRESS_SIZE;
+    entry.sequence = 0;
+    entry.stale = false;
+
+    if (entry.compressed)
+        entry.data = qCompress(entry.data);
+
+    if (it != m_messages.end())
+    {
+        m_size -= entrySize(topic, it.value());
+        m_lru.remove(it.value().sequence);
+        it.value() = entry;
+    }
+    else
+        it = m_messages.insert(topic, entry);
+
+    m_size += entrySize(topic, entry);
+    m_evicted.remove(topic);
+    touch(topic, it.value());
+
+    if (m_limit && m_size > m_limit)
+        evict();
+}
+
+void RetainedCache::remove(const QString &topic)
+{
+    auto it = m_messages.find(topic);
+
+    if (it == m_messages.end())
+        return;
+
+    m_size -= entrySize(topic, it.value());
+    m_lru.remove(it.value().sequence);
+    m_messages.erase(it);
+}
+
+void RetainedCache::expire(void)
+{
+    for (auto it = m_messages.begin(); it != m_messages.end(); it++)
+        it.value().stale = true;
+}
+
+int RetainedCache::purge(void)
+{
+    int count = 0;
+
+    for (auto it = m_messages.begin(); it != m_messages.end();)
+    {
+        if (!it.value().stale)
+        {
+            it++;
+            continue;
+        }
+
+        m_size -= entrySize(it.key(), it.value());
+        m_lru.remove(it.value().sequence);
+        it = m_messages.erase(it);
+        count++;
+    }
+
+    return count;
+}
+
+QList <QString> RetainedCache::topics(const QString &filter)
+{
+    int plus = filter.indexOf('+'), hash = filter.indexOf('#');
+    QList <QString> list;
+    QString prefix;
+    bool check;
+
+    if (plus < 0 && hash < 0)
+    {
+        auto it = m_messages.find(filter);
+
+        if (it != m_messages.end())
+            list.append(it.key());
+
+        return list;
+    }
+
+    prefix = filter.left(plus < 0 ? hash : hash < 0 ? plus : qMin(plus, hash));
+    check = plus >= 0 || hash != filter.length() - 1;
+
+    if (!check && prefix.endsWith('/'))
+    {
+        auto it = m_messages.find(prefix.left(prefix.length() - 1));
+
+        if (it != m_messages.end())
+            list.append(it.key());
+    }
+
+    for (auto it = m_messages.lowerBound(prefix); it != m_messages.end() && it.key().startsWith(prefix); it++)
+    {
+        if (check && !SubscriptionTree::topicMatch(filter, it.key()))
+            continue;
+
+        list.append(it.key());
+    }
+
+    return list;
+}
+
+QString RetainedCache::value(const QString &topic, bool stale)
+{
+    auto it = m_messages.find(topic);
+
+    if (it == m_messages.end())
+        return QString();
+
+    return frame(it.key(), it.value(), stale);
+}
+
+bool RetainedCache::refetch(const QString &filter)
+{
+    bool check = false;
+
+    for (auto it = m_evicted.begin(); it != m_evicted.end();)
+    {
+        if (!SubscriptionTree::topicMatch(filter, *it))
+        {
+            it++;
+            continue;
+        }
+
+        it = m_evicted.erase(it);
+        check = true;
+    }
+
+    return check;
+}
+
+QByteArray RetainedCache::data(void)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+
+    stream << static_cast <quint32> (m_messages.count());
+
+    for (auto it = m_messages.begin(); it != m_messages.end(); it++)
+        stream << it.key() << it.value().data << it.value().compressed << it.value().full;
+
+    return data;
+}
+
+bool RetainedCache::load(const QByteArray &data)
+{
+    QDataStream stream(data);
+    QMap <QString, RetainedEntry> messages;
+    qint64 size = 0;
+    quint32 count;
+
+    stream >> count;
+
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+    {
+        QString topic;
+        RetainedEntry entry;
+
+        stream >> topic >> entry.data >> entry.compressed >> entry.full;
+        entry.sequence = 0;
+        entry.stale = true;
+
+        size += entrySize(topic, entry);
+        messages.insert(topic, entry);
+    }
+
+    if (stream.status() != QDataStream::Ok)
+        return false;
+
+    m_messages = messages;
+    m_lru.clear();
+    m_size = size;
+
+    for (auto it = m_messages.begin(); it != m_messages.end(); it++)
+        touch(it.key(), it.value());
+
+    return true;
+}
+
+qint64 RetainedCache::entrySize(const QString &topic, const RetainedEntry &entry)
+{
+    return topic.length() * 2 + entry.data.length() + RETAINED_ENTRY_SIZE;
+}
+
+QString RetainedCache::frame(const QString &topic, RetainedEntry &entry, bool stale)
+{
+    QString frame = QString::fromUtf8(entry.compressed ? qUncompress(entry.data) : entry.data);
+
+    touch(topic, entry);
+
+    if (!entry.full)
+        frame = QString("{\"topic\":\"").append(topic).append("\",\"message\":").append(frame).append('}');
+
+    if (stale && entry.stale)
+        frame.insert(frame.length() - 1, ",\"stale\":true");
+
+    return frame;
+}
+
+void RetainedCache::touch(const QString &topic, RetainedEntry &entry)
+{
+    m_lru.remove(entry.sequence);
+    entry.sequence = ++m_sequence;
+    m_lru.insert(entry.sequence, topic);
+}
+
+void RetainedCache::evict(void)
+{
+    qint64 target = m_limit * 9 / 10;
+
+    while (m_size > target && !m_lru.isEmpty())
+    {
+        QString topic = m_lru.take(m_lru.firstKey());
+        auto it = m_messages.find(topic);
+
+        if (it == m_messages.end())
+            continue;
+
+        m_size -= entrySize(topic, it.value());
+        m_messages.erase(it);
+        m_evicted.insert(topic);
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef RETAINED_H
+#define RETAINED_H
+
+#define RETAINED_COMPRESS_SIZE  512
+#define RETAINED_ENTRY_SIZE     64
+
+#include <QMap>
+#include <QSet>
+
+struct RetainedEntry
+{
+    QByteArray data;
+    quint64 sequence;
+    bool compressed, full, stale;
+};
+
+class RetainedCache
+{
+
+public:
+
+    RetainedCache(void) : m_limit(0), m_size(0), m_sequence(0) {}
+
+    inline int count(void) { return m_messages.count(); }
+    inline qint64 size(void) { return m_size; }
+
+    inline void setLimit(qint64 value) { m_limit = value; }
+
+    void insert(const QString &topic, const QString &frame);
+    void remove(const QString &topic);
+
+    void expire(void);
+    int purge(void);
+
+    QList <QString> topics(const QString &filter);
+    QString value(const QString &topic, bool stale = true);
+    bool refetch(const QString &filter);
+
+    QByteArray data(void);
+    bool load(const QByteArray &data);
+
+private:
+
+    QMap <QString, RetainedEntry> m_messages;
+    QMap <quint64, QString> m_lru;
+    QSet <QString> m_evicted;
+    qint64 m_limit, m_size;
+    quint64 m_sequence;
+
+    qint64 entrySize(const QString &topic, const RetainedEntry &entry);
+    QString frame(const QString &topic, RetainedEntry &entry, bool stale);
+    void touch(const QString &topic, RetainedEntry &entry);
+    void evict(void);
+
+};
+
+#endif
@@ -0,0 +1,166 @@
+#include "subscriptions.h"
+
+void SubscriptionTree::insert(const QString &filter, QWebSocket *client)
+{
+    QList <QString> list = filter.split('/');
+    SubscriptionNode *node = m_root;
+
+    for (int i = 0; i < list.count(); i++)
+    {
+        auto it = node->m_children.find(list.at(i));
+
+        if (it == node->m_children.end())
+            it = node->m_children.insert(list.at(i), new SubscriptionNode);
+
+        node = it.value();
+
+        if (list.at(i) == "#")
+            break;
+    }
+
+    node->m_clients.insert(client);
+}
+
+void SubscriptionTree::remove(const QString &filter, QWebSocket *client)
+{
+    remove(m_root, filter.split('/'), 0, client);
+}
+
+QSet <QWebSocket*> SubscriptionTree::match(const QString &topic)
+{
+    QSet <QWebSocket*> clients;
+    match(m_root, topic.split('/'), 0, clients);
+    return clients;
+}
+
+bool SubscriptionTree::topicMatch(const QString &filter, const QString &topic)
+{
+    QList <QString> filterList = filter.split('/'), topicList = topic.split('/');
+
+    for (int i = 0; i < filterList.count(); i++)
+    {
+        if (filterList.at(i) == "#")
+            return true;
+
+        if (i == topicList.count() || (filterList.at(i) != "+" && filterList.at(i) != topicList.at(i)))
+            return false;
+    }
+
+    return filterList.count() == topicList.count();
+}
+
+bool SubscriptionTree::remove(SubscriptionNode *node, const QList <QString> &list, int index, QWebSocket *client)
+{
+    if (index == list.count() || (index && list.at(index - 1) == "#"))
+        node->m_clients.remove(client);
+    else
+    {
+        auto it = node->m_children.find(list.at(index));
+
+        if (it == node->m_children.end())
+            return false;
+
+        if (remove(it.value(), list, index + 1, client))
+        {
+            delete it.value();
+            node->m_children.erase(it);
+        }
+    }
+
+    return node != m_root && node->m_clients.isEmpty() && node->m_children.isEmpty();
+}
+
+void SubscriptionTree::match(SubscriptionNode *node, const QList <QString> &list, int index, QSet <QWebSocket*> &clients)
+{
+    auto it = node->m_children.find("#");
+
+    if (it != node->m_children.end())
+        clients.unite(it.value()->m_clients);
+
+    if (index == list.count())
+    {
+        clients.unite(node->m_clients);
+        return;
+    }
+
+    it = node->m_children.find(list.at(index));
+
+    if (it != node->m_children.end())
+        match(it.value(), list, index + 1, clients);
+
+    it = node->m_children.find("+");
+
+    if (it != node->m_children.end())
+        match(it.value(), list, index + 1, clients);
+}
+
+void SubscriptionManager::insert(const QString &filter)
+{
+    if (m_counts[filter]++)
+        return;
+
+    m_changed = true;
+}
+
+void SubscriptionManager::remove(const QString &filter)
+{
+    auto it = m_counts.find(filter);
+
+    if (it == m_counts.end() || --it.value())
+        return;
+
+    m_counts.erase(it);
+    m_changed = true;
+}
+
+void SubscriptionManager::update(QList <QString> &subscribe, QList <QString> &unsubscribe)
+{
+    QSet <QString> filters;
+
+    if (!m_changed)
+        return;
+
+    for (auto it = m_counts.begin(); it != m_counts.end(); it++)
+    {
+        bool covered = false;
+
+        for (auto item = m_counts.begin(); item != m_counts.end(); item++)
+        {
+            if (item == it || !filterCovers(item.key(), it.key()))
+                continue;
+
+            covered = true;
+            break;
+        }
+
+        if (!covered)
+            filters.insert(it.key());
+    }
+
+    for (auto it = filters.begin(); it != filters.end(); it++)
+        if (!m_active.contains(*it))
+            subscribe.append(*it);
+
+    for (auto it = m_active.begin(); it != m_active.end(); it++)
+        if (!filters.contains(*it))
+            unsubscribe.append(*it);
+
+    m_active = filters;
+    m_changed = false;
+}
+
+bool SubscriptionManager::filterCovers(const QString &filter, const QString &other)
+{
+    QList <QString> filterList = filter.split('/'), otherList = other.split('/');
+
+    for (int i = 0; i < filterList.count(); i++)
+    {
+        if (filterList.at(i) == "#")
+            return true;
+
+        if (i == otherList.count() || otherList.at(i) == "#" || (filterList.at(i) != "+" && filterList.at(i) != otherList.at(i)))
+            return false;
+    }
+
+    return filterList.count() == otherList.count();
+}
@@ -0,0 +1,70 @@
+#ifndef SUBSCRIPTIONS_H
+#define SUBSCRIPTIONS_H
+
+#include <QMap>
+#include <QSet>
+#include <QWebSocket>
+
+class SubscriptionNode
+{
+
+public:
+
+    ~SubscriptionNode(void) { qDeleteAll(m_children); }
+
+    QMap <QString, SubscriptionNode*> m_children;
+    QSet <QWebSocket*> m_clients;
+
+};
+
+class SubscriptionTree
+{
+
+public:
+
+    SubscriptionTree(void) : m_root(new SubscriptionNode) {}
+    ~SubscriptionTree(void) { delete m_root; }
+
+    void insert(const QString &filter, QWebSocket *client);
+    void remove(const QString &filter, QWebSocket *client);
+
+    QSet <QWebSocket*> match(const QString &topic);
+
+    static bool topicMatch(const QString &filter, const QString &topic);
+
+private:
+
+    SubscriptionNode *m_root;
+
+    bool remove(SubscriptionNode *node, const QList <QString> &list, int index, QWebSocket *client);
+    void match(SubscriptionNode *node, const QList <QString> &list, int index, QSet <QWebSocket*> &clients);
+
+    Q_DISABLE_COPY(SubscriptionTree)
+
+};
+
+class SubscriptionManager
+{
+
+public:
+
+    SubscriptionManager(void) : m_changed(false) {}
+
+    inline QList <QString> active(void) { return m_active.values(); }
+    inline bool active(const QString &filter) { return m_active.contains(filter); }
+
+    void insert(const QString &filter);
+    void remove(const QString &filter);
+    void update(QList <QString> &subscribe, QList <QString> &unsubscribe);
+
+    static bool filterCovers(const QString &filter, const QString &other);
+
+private:
+
+    QMap <QString, quint32> m_counts;
+    QSet <QString> m_active;
+    bool m_changed;
+
+};
+
+#endif
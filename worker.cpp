@@ -0,0 +1,502 @@
+#include <QCoreApplication>
+#include "controller.h"
+#include "logger.h"
+#include "worker.h"
+
+void Limiter::setLimits(int connections, int hostConnections, const QList <QString> &exempt)
+{
+    QMutexLocker lock(&m_mutex);
+    m_connections = connections;
+    m_hostConnections = hostConnections;
+    m_exempt.clear();
+
+    for (int i = 0; i < exempt.count(); i++)
+        m_exempt.insert(exempt.at(i));
+}
+
+bool Limiter::acquire(const QString &address)
+{
+    QMutexLocker lock(&m_mutex);
+    int &count = m_hosts[address];
+
+    if ((m_connections && m_count >= m_connections) || (m_hostConnections && count >= m_hostConnections && !m_exempt.contains(address)))
+    {
+        if (!count)
+            m_hosts.remove(address);
+
+        return false;
+    }
+
+    m_count++;
+    count++;
+    return true;
+}
+
+void Limiter::release(const QString &address)
+{
+    QMutexLocker lock(&m_mutex);
+    auto it = m_hosts.find(address);
+
+    if (it == m_hosts.end())
+        return;
+
+    m_count--;
+
+    if (--it.value() > 0)
+        return;
+
+    m_hosts.erase(it);
+}
+
+Worker::Worker(QSettings *config, AssetCache *assets, Database *database, Metrics *metrics, Limiter *limiter) : m_assets(assets), m_database(database), m_metrics(metrics), m_limiter(limiter), m_timer(new QTimer(this)), m_wheel(WHEEL_SIZE), m_tick(0)
+{
+    m_username = config->value("server/username").toString();
+    m_password = config->value("server/password").toString();
+    m_guest = config->value("server/guest").toString();
+
+    m_keepAliveTimeout = config->value("server/keepAliveTimeout", 5).toInt();
+    m_keepAliveRequests = config->value("server/keepAliveRequests", 100).toInt();
+    m_requestTimeout = config->value("server/requestTimeout", REQUEST_TIMEOUT).toInt();
+
+    m_headerLimit = config->value("server/maxHeaderSize", HTTP_MAX_HEADER_SIZE).toLongLong();
+    m_contentLimit = config->value("server/maxContentSize", HTTP_MAX_CONTENT_SIZE).toLongLong();
+
+    m_debug = config->value("server/debug", false).toBool();
+    m_auth = m_username.isEmpty() || m_password.isEmpty() ? false : true;
+
+    m_routes = {{"/manifest.json", Route::Public}, {"/logout", Route::Logout}, {"/metrics", Route::Metrics}};
+    m_prefixes = {{"/css/", Route::Public}, {"/font/", Route::Public}, {"/img/", Route::Public}};
+
+    connect(m_timer, &QTimer::timeout, this, &Worker::wheelTimeout);
+}
+
+Worker::Route Worker::findRoute(const QString &url)
+{
+    auto it = m_routes.find(url);
+
+    if (it != m_routes.end())
+        return it.value();
+
+    for (int i = 0; i < m_prefixes.count(); i++)
+        if (url.startsWith(m_prefixes.at(i).first))
+            return m_prefixes.at(i).second;
+
+    return Route::Private;
+}
+
+void Worker::schedule(const Connection &connection, quint32 timeout)
+{
+    cancel(connection);
+
+    if (!timeout)
+        return;
+
+    connection->setExpire(m_tick + (static_cast <qint64> (timeout) * 1000 + WHEEL_TICK - 1) / WHEEL_TICK + 1);
+    m_wheel[connection->expire() % WHEEL_SIZE].insert(connection->socket());
+}
+
+void Worker::cancel(const Connection &connection)
+{
+    if (connection->expire() < 0)
+        return;
+
+    m_wheel[connection->expire() % WHEEL_SIZE].remove(connection->socket());
+    connection->setExpire(-1);
+}
+
+void Worker::release(const Connection &connection)
+{
+    cancel(connection);
+    m_sockets.remove(connection->socket());
+    m_limiter->release(connection->address());
+    m_metrics->socketClosed();
+}
+
+void Worker::httpResponse(QTcpSocket *socket, quint16 code, const QMap <QString, QString> &headers, const QByteArray &response, const QSharedPointer <QFile> &file)
+{
+    Connection connection = m_sockets.value(socket);
+    QMap <QString, QString> list = headers;
+    QByteArray data;
+    bool keepAlive = !connection.isNull() && connection->keepAlive() && (!m_keepAliveRequests || connection->requests() < m_keepAliveRequests);
+
+    switch (code)
+    {
+       case 200: data = "HTTP/1.1 200 OK"; break;
+       case 301: data = "HTTP/1.1 301 Moved Permanently"; break;
+       case 304: data = "HTTP/1.1 304 Not Modified"; break;
+       case 400: data = "HTTP/1.1 400 Bad Request"; break;
+       case 404: data = "HTTP/1.1 404 Not Found"; break;
+       case 405: data = "HTTP/1.1 405 Method Not Allowed"; break;
+       case 500: data = "HTTP/1.1 500 Internal Server Error"; break;
+       case 503: data = "HTTP/1.1 503 Service Unavailable"; break;
+    }
+
+    m_metrics->httpRequest(code, connection.isNull() ? 0 : connection->elapsed());
+
+    if (code != 304 && !list.contains("Content-Length"))
+        list.insert("Content-Length", QString::number(response.length()));
+
+    if (keepAlive)
+    {
+        list.insert("Connection", "keep-alive");
+        list.insert("Keep-Alive", QString("timeout=%1").arg(m_keepAliveTimeout));
+    }
+    else
+        list.insert("Connection", "close");
+
+    for (auto it = list.begin(); it != list.end(); it++)
+        data.append(QString("\r\n%1: %2").arg(it.key(), it.value()).toUtf8());
+
+    data.append("\r\n\r\n");
+
+    if (!connection.isNull() && response.length() > HTTP_STREAM_CHUNK)
+    {
+        socket->write(data);
+        connection->setKeepAlive(keepAlive);
+        connection->setStream(response, file);
+
+        if (!connection->writeStream())
+        {
+            schedule(connection, m_requestTimeout);
+            return;
+        }
+    }
+    else
+        socket->write(data.append(response));
+
+    if (!keepAlive)
+    {
+        socket->close();
+        return;
+    }
+
+    schedule(connection, m_keepAliveTimeout);
+}
+
+void Worker::fileResponse(const Connection &connection, const QString &fileName)
+{
+    Asset asset = fileName == "/index.html" ? m_assets->index(m_auth) : m_assets->get(fileName);
+    QString encoding = connection->header("accept-encoding"), match = connection->header("if-none-match"), since = connection->header("if-modified-since"), etag;
+    QMap <QString, QString> headers;
+    QByteArray data;
+    bool check = false;
+
+    if (asset.isNull())
+    {
+        httpResponse(connection->socket(), 404);
+        return;
+    }
+
+    etag = asset->etag();
+    headers.insert("Content-Type", asset->type());
+
+    if (!asset->brotli().isEmpty() && encoding.contains("br"))
+    {
+        headers.insert("Content-Encoding", "br");
+        data = asset->brotli();
+        etag.append("-br");
+    }
+    else if (!asset->gzip().isEmpty() && encoding.contains("gzip"))
+    {
+        headers.insert("Content-Encoding", "gzip");
+        data = asset->gzip();
+        etag.append("-gz");
+    }
+    else
+        data = asset->data();
+
+    etag = QString("\"%1\"").arg(etag);
+
+    headers.insert("ETag", etag);
+    headers.insert("Last-Modified", AssetCache::httpDate(asset->modified()));
+    headers.insert("Cache-Control", asset->cacheControl());
+
+    if (!asset->gzip().isEmpty() || !asset->brotli().isEmpty())
+        headers.insert("Vary", "Accept-Encoding");
+
+    if (!match.isEmpty())
+    {
+        QList <QString> list = match.split(',');
+
+        for (int i = 0; i < list.count(); i++)
+        {
+            QString item = list.at(i).trimmed();
+
+            if (item.startsWith("W/"))
+                item.remove(0, 2);
+
+            if (item != "*" && item != etag)
+                continue;
+
+            check = true;
+            break;
+        }
+    }
+    else if (!since.isEmpty())
+    {
+        QDateTime dateTime = AssetCache::httpDate(since);
+        check = dateTime.isValid() && asset->modified() <= dateTime;
+    }
+
+    if (check)
+    {
+        headers.remove("Content-Type");
+        httpResponse(connection->socket(), 304, headers);
+        return;
+    }
+
+    headers.insert("Content-Length", QString::number(data.length()));
+    httpResponse(connection->socket(), 200, headers, data, asset->file());
+}
+
+void Worker::requestReceived(const Connection &connection)
+{
+    QTcpSocket *socket = connection->socket();
+    QString url = connection->path();
+    QByteArray method = connection->method(), header = connection->header("connection").toLower();
+    Route route = connection->status() != ConnectionObject::Status::Upgrade ? findRoute(url) : Route::Upgrade;
+    QMap <QString, QString> items;
+    bool guest = false;
+
+    if (m_debug)
+    {
+        QMap <QByteArray, QByteArray> headers = connection->headers();
+
+        logDebug(m_debug) << "Request" << method << connection->url() << "received from" << socket->peerAddress().toString();
+
+        for (auto it = headers.begin(); it != headers.end(); it++)
+            logDebug(m_debug) << "Header received:" << it.key() << it.value();
+    }
+
+    if (connection->status() == ConnectionObject::Status::Error)
+    {
+        connection->setKeepAlive(false);
+        httpResponse(socket, 400);
+        return;
+    }
+
+    connection->setKeepAlive(m_keepAliveTimeout && connection->status() != ConnectionObject::Status::Upgrade && (connection->version() == "HTTP/1.1" ? !header.contains("close") : header.contains("keep-alive")));
+
+    if (route == Route::Public && method == "GET")
+    {
+        fileResponse(connection, url);
+        return;
+    }
+
+    if (m_auth && route != Route::Public)
+    {
+        QString token = connection->cookie("homed-auth-token");
+
+        if (token != m_database->adminToken() && token != m_database->guestToken())
+        {
+            if (method == "POST")
+            {
+                QString username, password;
+
+                items = connection->items();
+                username = items.value("username");
+                password = items.value("password");
+
+                if (username == m_username && password == m_password)
+                {
+                    httpResponse(socket, 301, {{"Location", QString(connection->header("x-ingress-path")).append('/')}, {"Cache-Control", "no-cache, no-store"}, {"Set-Cookie", QString("homed-auth-token=%1; path=/; max-age=%2").arg(m_database->adminToken()).arg(COOKIE_MAX_AGE)}});
+                    return;
+                }
+
+                if (!m_guest.isEmpty() && username == "guest" && password == m_guest)
+                {
+                    httpResponse(socket, 301, {{"Location", QString(connection->header("x-ingress-path")).append('/')}, {"Cache-Control", "no-cache, no-store"}, {"Set-Cookie", QString("homed-auth-token=%1; path=/; max-age=%2").arg(m_database->guestToken()).arg(COOKIE_MAX_AGE)}});
+                    return;
+                }
+            }
+
+            fileResponse(connection, "/login.html");
+            return;
+        }
+
+        guest = token != m_database->adminToken() ? true : false;
+    }
+
+    if (route == Route::Logout)
+    {
+        httpResponse(socket, 301, {{"Location", QString(connection->header("x-ingress-path")).append('/')}, {"Cache-Control", "no-cache, no-store"}, {"Set-Cookie", "homed-auth-token=deleted; path=/; max-age=0"}});
+
+        if (guest || connection->items().value("session") != "all")
+            return;
+
+        emit logoutRequest();
+        return;
+    }
+
+    if (method != "GET")
+    {
+        httpResponse(socket, 405);
+        return;
+    }
+
+    if (route == Route::Metrics)
+    {
+        httpResponse(socket, 200, {{"Content-Type", "text/plain; version=0.0.4"}, {"Cache-Control", "no-cache, no-store"}}, m_metrics->text());
+        return;
+    }
+
+    if (route == Route::Upgrade)
+    {
+        disconnect(socket, nullptr, this, nullptr);
+        release(connection);
+
+        socket->setProperty("guest", guest);
+        socket->setParent(nullptr);
+        socket->moveToThread(QCoreApplication::instance()->thread());
+
+        emit upgradeRequest(socket);
+        return;
+    }
+
+    fileResponse(connection, url != "/" ? url : "/index.html");
+}
+
+void Worker::parseRequests(const Connection &connection)
+{
+    QTcpSocket *socket = connection->socket();
+
+    while (connection->parse())
+    {
+        ConnectionObject::Status status = connection->status();
+
+        cancel(connection);
+        requestReceived(connection);
+
+        if (status == ConnectionObject::Status::Upgrade || socket->state() != QAbstractSocket::ConnectedState)
+            return;
+
+        connection->reset();
+
+        if (connection->streaming())
+            return;
+    }
+}
+
+void Worker::newConnection(qintptr descriptor)
+{
+    QTcpSocket *socket = new QTcpSocket(this);
+    Connection connection;
+
+    if (!socket->setSocketDescriptor(descriptor))
+    {
+        logWarning << "Socket descriptor" << descriptor << "setup failed:" << socket->errorString();
+        delete socket;
+        return;
+    }
+
+    if (!m_limiter->acquire(socket->peerAddress().toString()))
+    {
+        logDebug(m_debug) << "Connection from" << socket->peerAddress().toString() << "rejected, limit reached";
+        connect(socket, &QTcpSocket::disconnected, socket, &QTcpSocket::deleteLater);
+        m_metrics->socketRejected();
+        httpResponse(socket, 503);
+        return;
+    }
+
+    connection = Connection(new ConnectionObject(socket, m_headerLimit, m_contentLimit));
+
+    connect(socket, &QTcpSocket::disconnected, this, &Worker::socketDisconnected);
+    connect(socket, &QTcpSocket::readyRead, this, &Worker::readyRead);
+    connect(socket, &QTcpSocket::bytesWritten, this, &Worker::bytesWritten);
+
+    if (!m_timer->isActive())
+        m_timer->start(WHEEL_TICK);
+
+    m_sockets.insert(socket, connection);
+    m_metrics->socketOpened();
+    schedule(connection, m_requestTimeout);
+}
+
+void Worker::socketDisconnected(void)
+{
+    QTcpSocket *socket = reinterpret_cast <QTcpSocket*> (sender());
+    Connection connection = m_sockets.value(socket);
+
+    if (!connection.isNull())
+        release(connection);
+
+    socket->deleteLater();
+}
+
+void Worker::readyRead(void)
+{
+    QTcpSocket *socket = reinterpret_cast <QTcpSocket*> (sender());
+    Connection connection = m_sockets.value(socket);
+
+    if (connection.isNull() || connection->streaming())
+        return;
+
+    if (connection->idle())
+        schedule(connection, m_requestTimeout);
+
+    parseRequests(connection);
+}
+
+void Worker::bytesWritten(void)
+{
+    QTcpSocket *socket = reinterpret_cast <QTcpSocket*> (sender());
+    Connection connection = m_sockets.value(socket);
+
+    if (connection.isNull() || !connection->streaming())
+        return;
+
+    if (!connection->writeStream())
+    {
+        schedule(connection, m_requestTimeout);
+        return;
+    }
+
+    if (!connection->keepAlive())
+    {
+        socket->close();
+        return;
+    }
+
+    schedule(connection, m_keepAliveTimeout);
+    parseRequests(connection);
+}
+
+void Worker::wheelTimeout(void)
+{
+    QSet <QTcpSocket*> &slot = m_wheel[++m_tick % WHEEL_SIZE];
+    QList <QTcpSocket*> list;
+
+    for (auto it = slot.begin(); it != slot.end(); it++)
+    {
+        Connection connection = m_sockets.value(*it);
+
+        if (connection.isNull() || connection->expire() > m_tick)
+            continue;
+
+        list.append(*it);
+    }
+
+    for (int i = 0; i < list.count(); i++)
+    {
+        Connection connection = m_sockets.value(list.at(i));
+
+        if (!connection->idle() || !connection->requests() || connection->streaming())
+            m_metrics->socketTimeout();
+
+        cancel(connection);
+        list.at(i)->abort();
+
+        if (!m_sockets.contains(list.at(i)))
+            continue;
+
+        release(connection);
+        list.at(i)->deleteLater();
+    }
+}
+
+void Server::incomingConnection(qintptr descriptor)
+{
+    Worker *worker = m_workers.at(m_index);
+    m_index = (m_index + 1) % m_workers.count();
+    QMetaObject::invokeMethod(worker, "newConnection", Q_ARG(qintptr, descriptor));
+}
@@ -0,0 +1,125 @@
+#ifndef WORKER_H
+#define WORKER_H
+
+#define WHEEL_TICK              1000
+#define WHEEL_SIZE              64
+#define REQUEST_TIMEOUT         10
+#define MAX_CONNECTIONS         256
+#define MAX_HOST_CONNECTIONS    32
+
+#include <QMutex>
+#include <QSet>
+#include <QTcpServer>
+#include <QTimer>
+#include "assets.h"
+#include "database.h"
+#include "http.h"
+#include "metrics.h"
+
+class Limiter
+{
+
+public:
+
+    Limiter(void) : m_connections(0), m_hostConnections(0), m_count(0) {}
+
+    void setLimits(int connections, int hostConnections, const QList <QString> &exempt);
+
+    bool acquire(const QString &address);
+    void release(const QString &address);
+
+private:
+
+    QMutex m_mutex;
+    int m_connections, m_hostConnections, m_count;
+    QMap <QString, int> m_hosts;
+    QSet <QString> m_exempt;
+
+};
+
+class Worker : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    enum class Route
+    {
+        Public,
+        Private,
+        Logout,
+        Metrics,
+        Upgrade
+    };
+
+    Worker(QSettings *config, AssetCache *assets, Database *database, Metrics *metrics, Limiter *limiter);
+
+private:
+
+    AssetCache *m_assets;
+    Database *m_database;
+    Metrics *m_metrics;
+    Limiter *m_limiter;
+    QTimer *m_timer;
+
+    QString m_username, m_password, m_guest;
+    quint32 m_keepAliveTimeout, m_keepAliveRequests, m_requestTimeout;
+    qint64 m_headerLimit, m_contentLimit;
+    bool m_debug, m_auth;
+
+    QMap <QTcpSocket*, Connection> m_sockets;
+    QVector <QSet <QTcpSocket*>> m_wheel;
+    qint64 m_tick;
+
+    QMap <QString, Route> m_routes;
+    QList <QPair <QString, Route>> m_prefixes;
+
+    Route findRoute(const QString &url);
+
+    void schedule(const Connection &connection, quint32 timeout);
+    void cancel(const Connection &connection);
+    void release(const Connection &connection);
+
+    void httpResponse(QTcpSocket *socket, quint16 code, const QMap <QString, QString> &headers = QMap <QString, QString> (), const QByteArray &response = QByteArray(), const QSharedPointer <QFile> &file = QSharedPointer <QFile> ());
+    void fileResponse(const Connection &connection, const QString &fileName);
+    void requestReceived(const Connection &connection);
+    void parseRequests(const Connection &connection);
+
+public slots:
+
+    void newConnection(qintptr descriptor);
+
+private slots:
+
+    void socketDisconnected(void);
+    void readyRead(void);
+    void bytesWritten(void);
+    void wheelTimeout(void);
+
+signals:
+
+    void upgradeRequest(QTcpSocket *socket);
+    void logoutRequest(void);
+
+};
+
+class Server : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+
+    Server(QObject *parent) : QTcpServer(parent), m_index(0) {}
+
+    inline void addWorker(Worker *worker) { m_workers.append(worker); }
+
+private:
+
+    QList <Worker*> m_workers;
+    int m_index;
+
+    void incomingConnection(qintptr descriptor) override;
+
+};
+
+#endif